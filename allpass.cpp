@@ -11,10 +11,42 @@ allpass::allpass()
 	bufidx = 0;
 }
 
-void allpass::setbuffer(float *buf, int size) 
+void allpass::setbuffer(delay_sample *buf, int size) 
 {
 	buffer = buf; 
 	bufsize = size;
+	bufidx = 0;
+}
+
+// Block version of process(), split at the ring buffer wrap point.
+// Within one run each sample only touches its own buffer slot, so the
+// inner loop carries no dependency and can be vectorised. inp and out
+// may point to the same buffer.
+
+void allpass::process_block(const float *inp, float *out, int n)
+{
+	while (n > 0)
+	{
+		int len = bufsize-bufidx;
+		if (len > n) len = n;
+
+		delay_run(buffer+bufidx, len, [&](float *buf, int pos, int count)
+		{
+			for (int i=0; i<count; i++)
+			{
+				float input = inp[pos+i];
+				float bufout = undenormalised(buf[i]);
+				buf[i] = input + (bufout*feedback);
+				out[pos+i] = -input + bufout;
+			}
+		});
+
+		bufidx += len;
+		if (bufidx>=bufsize) bufidx = 0;
+		inp += len;
+		out += len;
+		n -= len;
+	}
 }
 
 void allpass::mute()
@@ -7,19 +7,21 @@
 #ifndef _allpass_
 #define _allpass_
 #include "denormals.h"
+#include "delay_storage.h"
 
 class allpass
 {
 public:
 					allpass();
-			void	setbuffer(float *buf, int size);
+			void	setbuffer(delay_sample *buf, int size);
 	inline  float	process(float inp);
+			void	process_block(const float *inp, float *out, int n);
 			void	mute();
 			void	setfeedback(float val);
 			float	getfeedback();
 // private:
 	float	feedback;
-	float	*buffer;
+	delay_sample	*buffer;
 	int		bufsize;
 	int		bufidx;
 };
@@ -32,11 +34,11 @@ inline float allpass::process(float input)
 	float output;
 	float bufout;
 	
-	bufout = buffer[bufidx];
+	bufout = delay_read(buffer[bufidx]);
 	undenormalise(bufout);
 	
 	output = -input + bufout;
-	buffer[bufidx] = input + (bufout*feedback);
+	buffer[bufidx] = delay_write(input + (bufout*feedback));
 
 	if(++bufidx>=bufsize) bufidx = 0;
 
@@ -0,0 +1,115 @@
+// Fixed-point allpass filter declaration
+//
+// Same structure as allpass, with sample_t = int16_t (Q15) or int32_t (Q31)
+// samples and delay lines.
+
+#ifndef _allpass_fixed_
+#define _allpass_fixed_
+
+#include "fixed.h"
+
+template <typename sample_t>
+class allpass_fixed
+{
+public:
+	enum { coefbits = fixed_format<sample_t>::fracbits-1 };
+
+					allpass_fixed();
+			void	setbuffer(sample_t *buf, int size);
+	inline  sample_t	process(sample_t inp);
+			void	process_block(const sample_t *inp, sample_t *out, int n);
+			void	mute();
+			void	setfeedback(float val);
+			float	getfeedback();
+private:
+	sample_t	feedback;
+	float		feedbackvalue;
+	sample_t	*buffer;
+	int			bufsize;
+	int			bufidx;
+};
+
+template <typename sample_t>
+allpass_fixed<sample_t>::allpass_fixed()
+{
+	feedback = 0;
+	feedbackvalue = 0;
+	buffer = 0;
+	bufsize = 0;
+	bufidx = 0;
+}
+
+template <typename sample_t>
+void allpass_fixed<sample_t>::setbuffer(sample_t *buf, int size)
+{
+	buffer = buf;
+	bufsize = size;
+	bufidx = 0;
+}
+
+// Big to inline - but crucial for speed
+
+template <typename sample_t>
+inline sample_t allpass_fixed<sample_t>::process(sample_t input)
+{
+	sample_t bufout = buffer[bufidx];
+
+	sample_t output = fixed_sub(bufout, input);
+	buffer[bufidx] = fixed_add(input, fixed_mul(bufout, feedback, coefbits));
+
+	if(++bufidx>=bufsize) bufidx = 0;
+
+	return output;
+}
+
+// Block version of process(), split at the ring buffer wrap point like
+// allpass::process_block. inp and out may be the same buffer.
+
+template <typename sample_t>
+void allpass_fixed<sample_t>::process_block(const sample_t *inp, sample_t *out, int n)
+{
+	while (n > 0)
+	{
+		int len = bufsize-bufidx;
+		if (len > n) len = n;
+
+		sample_t *buf = buffer+bufidx;
+		for (int i=0; i<len; i++)
+		{
+			sample_t input = inp[i];
+			sample_t bufout = buf[i];
+			buf[i] = fixed_add(input, fixed_mul(bufout, feedback, coefbits));
+			out[i] = fixed_sub(bufout, input);
+		}
+
+		bufidx += len;
+		if (bufidx>=bufsize) bufidx = 0;
+		inp += len;
+		out += len;
+		n -= len;
+	}
+}
+
+template <typename sample_t>
+void allpass_fixed<sample_t>::mute()
+{
+	for (int i=0; i<bufsize; i++)
+		buffer[i]=0;
+}
+
+template <typename sample_t>
+void allpass_fixed<sample_t>::setfeedback(float val)
+{
+	feedbackvalue = val;
+	feedback = fixed_from_float<sample_t>(val, coefbits);
+}
+
+template <typename sample_t>
+float allpass_fixed<sample_t>::getfeedback()
+{
+	return feedbackvalue;
+}
+
+#endif//_allpass_fixed_
+
+//ends
@@ -0,0 +1,436 @@
+// Throughput benchmark for mk_freeverb
+//
+// Times process_block of one reverb configuration (comb count and features
+// are picked at run time through make_mk_freeverb, see run_matrix.sh) for a
+// range of block sizes and instance counts and prints Google Benchmark
+// style JSON: a "context" object describing the build and configuration
+// and one "benchmarks" entry per (block size, instances) pair with
+// ns/sample, cycles/sample, cache misses/sample and the worst-case time of
+// one block (max_block_time, see run_case).
+//
+// Cycles and cache misses come from perf_event on Linux. Without access to
+// the counters, cycles fall back to the x86 time stamp counter and cache
+// misses are reported as null.
+//
+// Usage: mk_freeverb_bench [--combs=1-8] [--features=mask] [--min-time=seconds]
+//                          [--block-sizes=16,64,...] [--instances=1,4,16]
+//                          [--sample-rate=hz] [--automate] [--out=file]
+// --features is a ReverbFeatures mask: 1 predelay, 2 crossfade, 4 input filter.
+// Both default to the MK_FREEVERB_* macro configuration.
+
+#include "mk_freeverb.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <memory>
+#include <string>
+#include <vector>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#include <x86intrin.h>
+#define MK_BENCH_HAVE_TSC 1
+#else
+#define MK_BENCH_HAVE_TSC 0
+#endif
+
+namespace {
+
+struct Options
+{
+    int numCombs = MK_FREEVERB_NUM_COMBS;
+    unsigned features = ReverbFeatures::Default;
+    double minTime = 0.25;
+    float sampleRate = 48000.f;
+    bool automate = false;
+    std::vector<int> blockSizes = {16, 32, 64, 128, 256, 512, 1024};
+    std::vector<int> instances = {1, 4, 16};
+    const char *out = nullptr;
+};
+
+// Hardware counter, or an unavailable one that reads as -1
+class Counter
+{
+public:
+    Counter(unsigned type, unsigned long long config)
+    {
+#if defined(__linux__)
+        perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = type;
+        attr.config = config;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        fd = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+#else
+        (void)type;
+        (void)config;
+#endif
+    }
+
+    ~Counter()
+    {
+#if defined(__linux__)
+        if (fd >= 0) close(fd);
+#endif
+    }
+
+    Counter(const Counter&) = delete;
+    Counter& operator=(const Counter&) = delete;
+
+    bool valid() const { return fd >= 0; }
+
+    void start()
+    {
+#if defined(__linux__)
+        if (fd < 0) return;
+        ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+#endif
+    }
+
+    long long stop()
+    {
+#if defined(__linux__)
+        if (fd < 0) return -1;
+        ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        long long value = 0;
+        if (read(fd, &value, sizeof(value)) != sizeof(value)) return -1;
+        return value;
+#else
+        return -1;
+#endif
+    }
+
+private:
+    int fd = -1;
+};
+
+#if defined(__linux__)
+const unsigned counterHardware = PERF_TYPE_HARDWARE;
+const unsigned long long counterCycles = PERF_COUNT_HW_CPU_CYCLES;
+const unsigned long long counterCacheMisses = PERF_COUNT_HW_CACHE_MISSES;
+#else
+const unsigned counterHardware = 0;
+const unsigned long long counterCycles = 0;
+const unsigned long long counterCacheMisses = 0;
+#endif
+
+unsigned long long read_tsc()
+{
+#if MK_BENCH_HAVE_TSC
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+struct Result
+{
+    int blockSize;
+    int instances;
+    long long iterations;
+    double realNs;          // per iteration (one block on every instance)
+    double cpuNs;
+    double nsPerSample;
+    double cyclesPerSample; // < 0 when unavailable
+    double missesPerSample; // < 0 when unavailable
+    double maxBlockNs;      // slowest block position of the period
+};
+
+// Deterministic white noise so the reverb never goes to sleep
+void fill_noise(std::vector<float>& buf, unsigned seed)
+{
+    for (float& s : buf)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        s = (float)(int)(seed >> 8) / 8388608.f - 1.f;
+        s *= 0.5f;
+    }
+}
+
+const char *simd_name()
+{
+#if MK_FREEVERB_SIMD_AVX
+    return "avx";
+#elif MK_FREEVERB_SIMD_SSE
+    return "sse2";
+#elif MK_FREEVERB_SIMD_NEON
+    return "neon";
+#else
+    return "scalar";
+#endif
+}
+
+const char *denormal_mode_name()
+{
+#if MK_FREEVERB_DENORMAL_MODE == MK_FREEVERB_DENORMALS_FTZ
+    return "ftz";
+#elif MK_FREEVERB_DENORMAL_MODE == MK_FREEVERB_DENORMALS_OFFSET
+    return "offset";
+#else
+    return "check";
+#endif
+}
+
+const char *delay_storage_name()
+{
+#if MK_FREEVERB_DELAY_STORAGE == MK_FREEVERB_DELAY_INT16
+    return "int16";
+#elif MK_FREEVERB_DELAY_STORAGE == MK_FREEVERB_DELAY_FP16
+    return "fp16";
+#else
+    return "float";
+#endif
+}
+
+Result run_case(const Options& opt, int blockSize, int numInstances,
+                Counter& cycles, Counter& misses)
+{
+    std::vector<std::unique_ptr<mk_freeverb_processor>> reverbs;
+    for (int k = 0; k < numInstances; k++)
+    {
+        reverbs.push_back(make_mk_freeverb(opt.numCombs, opt.features, opt.sampleRate));
+        reverbs.back()->queue_preset_by_index(k % ReverbPresets::NUM_PRESETS);
+        reverbs.back()->queue_param(ReverbParamEvent::Predelay, 0.02f);
+    }
+
+    // Independent input and output per instance, as a host would have
+    const int period = 8192;
+    std::vector<float> inL(period + blockSize), inR(period + blockSize);
+    fill_noise(inL, 1);
+    fill_noise(inR, 2);
+    std::vector<std::vector<float>> outL(numInstances, std::vector<float>(blockSize));
+    std::vector<std::vector<float>> outR(numInstances, std::vector<float>(blockSize));
+
+    long long position = 0;
+    auto iteration = [&]() {
+        const int offset = (int)(position % period);
+        // Optional predelay automation, to exercise the crossfade path
+        if (opt.automate && offset < blockSize)
+        {
+            const float predelay = (position / period) & 1 ? 0.03f : 0.02f;
+            for (auto& reverb : reverbs)
+                reverb->queue_param(ReverbParamEvent::Predelay, predelay);
+        }
+        for (int k = 0; k < numInstances; k++)
+        {
+            reverbs[k]->process_block(inL.data() + offset, inR.data() + offset,
+                                      outL[k].data(), outR[k].data(), blockSize);
+        }
+        position += blockSize;
+    };
+
+    // Warm up caches, the branch predictor and the reverb tail
+    const long long warmup = (long long)(opt.sampleRate * 0.1f) / blockSize + 1;
+    for (long long i = 0; i < warmup; i++)
+        iteration();
+
+    // Size the timed batch so it lasts about minTime
+    long long iterations = 1;
+    double realNs = 0;
+    for (;;)
+    {
+        auto t0 = std::chrono::steady_clock::now();
+        for (long long i = 0; i < iterations; i++)
+            iteration();
+        realNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count();
+        if (realNs >= opt.minTime * 1e9 * 0.1 || iterations >= (1ll << 40)) break;
+        iterations *= 10;
+    }
+    iterations = (long long)(iterations * (opt.minTime * 1e9 / realNs)) + 1;
+
+    cycles.start();
+    misses.start();
+    const unsigned long long tsc0 = read_tsc();
+    const std::clock_t c0 = std::clock();
+    auto t0 = std::chrono::steady_clock::now();
+
+    for (long long i = 0; i < iterations; i++)
+        iteration();
+
+    realNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count();
+    const double cpuNs = (double)(std::clock() - c0) * 1e9 / CLOCKS_PER_SEC;
+    const unsigned long long tsc = read_tsc() - tsc0;
+    const long long missCount = misses.stop();
+    long long cycleCount = cycles.stop();
+    if (cycleCount < 0 && MK_BENCH_HAVE_TSC)
+        cycleCount = (long long)tsc;
+
+    // Worst case: time every block of eight automation periods one by
+    // one. Each block position of the period keeps its fastest run, which
+    // drops interrupts and preemption; the slowest position is reported.
+    // Predelay moves and crossfade ends land on fixed positions.
+    std::vector<double> blockNs((period + blockSize - 1) / blockSize, 1e300);
+    for (long long i = 0; i < 8 * (long long)blockNs.size(); i++)
+    {
+        const size_t slot = (size_t)((position % period) / blockSize);
+        auto b0 = std::chrono::steady_clock::now();
+        iteration();
+        const double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - b0).count();
+        if (ns < blockNs[slot]) blockNs[slot] = ns;
+    }
+    double maxBlockNs = 0;
+    for (double ns : blockNs)
+        if (ns < 1e300 && ns > maxBlockNs) maxBlockNs = ns;
+
+    const double samples = (double)iterations * blockSize * numInstances;
+
+    Result r;
+    r.blockSize = blockSize;
+    r.instances = numInstances;
+    r.iterations = iterations;
+    r.realNs = realNs / iterations;
+    r.cpuNs = cpuNs / iterations;
+    r.nsPerSample = realNs / samples;
+    r.cyclesPerSample = cycleCount < 0 ? -1.0 : cycleCount / samples;
+    r.missesPerSample = missCount < 0 ? -1.0 : missCount / samples;
+    r.maxBlockNs = maxBlockNs;
+    return r;
+}
+
+std::vector<int> parse_list(const char *s)
+{
+    std::vector<int> values;
+    while (*s)
+    {
+        char *end;
+        long v = strtol(s, &end, 10);
+        if (end == s) break;
+        if (v > 0) values.push_back((int)v);
+        s = *end == ',' ? end + 1 : end;
+    }
+    return values;
+}
+
+bool parse_args(int argc, char **argv, Options& opt)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        const char *a = argv[i];
+        if (!strncmp(a, "--combs=", 8)) opt.numCombs = atoi(a + 8);
+        else if (!strncmp(a, "--features=", 11)) opt.features = (unsigned)strtoul(a + 11, nullptr, 0);
+        else if (!strncmp(a, "--min-time=", 11)) opt.minTime = atof(a + 11);
+        else if (!strncmp(a, "--block-sizes=", 14)) opt.blockSizes = parse_list(a + 14);
+        else if (!strncmp(a, "--instances=", 12)) opt.instances = parse_list(a + 12);
+        else if (!strncmp(a, "--sample-rate=", 14)) opt.sampleRate = (float)atof(a + 14);
+        else if (!strcmp(a, "--automate")) opt.automate = true;
+        else if (!strncmp(a, "--out=", 6)) opt.out = a + 6;
+        else
+        {
+            fprintf(stderr, "unknown option %s\n", a);
+            return false;
+        }
+    }
+    return opt.numCombs >= 1 && opt.numCombs <= numcombs && opt.features <= ReverbFeatures::All &&
+           opt.minTime > 0 && opt.sampleRate > 0 && !opt.blockSizes.empty() && !opt.instances.empty();
+}
+
+void print_number(FILE *f, double v)
+{
+    if (v < 0) fprintf(f, "null");
+    else fprintf(f, "%.6g", v);
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    Options opt;
+    if (!parse_args(argc, argv, opt))
+    {
+        fprintf(stderr, "usage: %s [--combs=1-8] [--features=0-7] [--min-time=s] [--block-sizes=16,32,...]"
+                        " [--instances=1,4,16] [--sample-rate=hz] [--automate] [--out=file]\n", argv[0]);
+        return 1;
+    }
+
+    Counter cycles(counterHardware, counterCycles);
+    Counter misses(counterHardware, counterCacheMisses);
+    const char *cycleSource = cycles.valid() ? "perf" : (MK_BENCH_HAVE_TSC ? "tsc" : "none");
+
+    std::vector<Result> results;
+    for (int instances : opt.instances)
+    {
+        for (int blockSize : opt.blockSizes)
+        {
+            results.push_back(run_case(opt, blockSize, instances, cycles, misses));
+            const Result& r = results.back();
+            fprintf(stderr, "block %4d  instances %2d  %8.2f ns/sample  max block %9.0f ns\n",
+                    r.blockSize, r.instances, r.nsPerSample, r.maxBlockNs);
+        }
+    }
+
+    FILE *f = opt.out ? fopen(opt.out, "w") : stdout;
+    if (!f)
+    {
+        fprintf(stderr, "cannot open %s\n", opt.out);
+        return 1;
+    }
+
+    char date[32];
+    const std::time_t now = std::time(nullptr);
+    std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", std::localtime(&now));
+
+    fprintf(f, "{\n  \"context\": {\n");
+    fprintf(f, "    \"date\": \"%s\",\n", date);
+#if defined(__linux__)
+    fprintf(f, "    \"num_cpus\": %ld,\n", sysconf(_SC_NPROCESSORS_ONLN));
+#endif
+#ifdef NDEBUG
+    fprintf(f, "    \"library_build_type\": \"release\",\n");
+#else
+    fprintf(f, "    \"library_build_type\": \"debug\",\n");
+#endif
+    // Report what the instantiation actually compiled in
+    const unsigned features = make_mk_freeverb(opt.numCombs, opt.features, opt.sampleRate)->features();
+    fprintf(f, "    \"num_combs\": %d,\n", opt.numCombs);
+    fprintf(f, "    \"predelay\": %d,\n", (features & ReverbFeatures::Predelay) ? 1 : 0);
+    fprintf(f, "    \"predelay_crossfade\": %d,\n", (features & ReverbFeatures::PredelayCrossfade) ? 1 : 0);
+    fprintf(f, "    \"input_filter\": %d,\n", (features & ReverbFeatures::InputFilter) ? 1 : 0);
+    fprintf(f, "    \"comb_bank\": %d,\n", MK_FREEVERB_ENABLE_COMB_BANK);
+    fprintf(f, "    \"smoothing\": %d,\n", MK_FREEVERB_ENABLE_SMOOTHING);
+    fprintf(f, "    \"simd\": \"%s\",\n", simd_name());
+    fprintf(f, "    \"denormal_mode\": \"%s\",\n", denormal_mode_name());
+    fprintf(f, "    \"delay_storage\": \"%s\",\n", delay_storage_name());
+    fprintf(f, "    \"sample_rate\": %g,\n", opt.sampleRate);
+    fprintf(f, "    \"automate\": %s,\n", opt.automate ? "true" : "false");
+    fprintf(f, "    \"cycle_counter\": \"%s\",\n", cycleSource);
+    fprintf(f, "    \"cache_miss_counter\": \"%s\"\n", misses.valid() ? "perf" : "none");
+    fprintf(f, "  },\n  \"benchmarks\": [\n");
+
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        const Result& r = results[i];
+        fprintf(f, "    {\n");
+        fprintf(f, "      \"name\": \"process_block/%d/%d\",\n", r.blockSize, r.instances);
+        fprintf(f, "      \"run_type\": \"iteration\",\n");
+        fprintf(f, "      \"block_size\": %d,\n", r.blockSize);
+        fprintf(f, "      \"instances\": %d,\n", r.instances);
+        fprintf(f, "      \"iterations\": %lld,\n", r.iterations);
+        fprintf(f, "      \"real_time\": %.6g,\n", r.realNs);
+        fprintf(f, "      \"cpu_time\": %.6g,\n", r.cpuNs);
+        fprintf(f, "      \"time_unit\": \"ns\",\n");
+        fprintf(f, "      \"ns_per_sample\": %.6g,\n", r.nsPerSample);
+        fprintf(f, "      \"max_block_time\": %.6g,\n", r.maxBlockNs);
+        fprintf(f, "      \"cycles_per_sample\": ");
+        print_number(f, r.cyclesPerSample);
+        fprintf(f, ",\n      \"cache_misses_per_sample\": ");
+        print_number(f, r.missesPerSample);
+        fprintf(f, "\n    }%s\n", i + 1 < results.size() ? "," : "");
+    }
+    fprintf(f, "  ]\n}\n");
+
+    if (f != stdout) fclose(f);
+    return 0;
+}
@@ -0,0 +1,53 @@
+#!/bin/sh
+# Builds mk_freeverb_bench once and runs it for every configuration:
+# 1-8 combs x predelay x crossfade x input filter, selected at run time
+# through make_mk_freeverb. Crossfade only exists together with predelay,
+# so the redundant predelay=0/crossfade=1 runs are skipped.
+#
+# Usage: bench/run_matrix.sh [output dir] [bench options...]
+# Environment: CXX (default c++), CXXFLAGS (default -O2 -march=native)
+#
+# Writes one JSON file per configuration plus matrix.json holding all runs.
+
+set -e
+
+root=$(cd "$(dirname "$0")/.." && pwd)
+out=${1:-bench-results}
+[ $# -gt 0 ] && shift
+cxx=${CXX:-c++}
+flags=${CXXFLAGS:--O2 -march=native}
+
+mkdir -p "$out"
+bench="$out/mk_freeverb_bench"
+$cxx -std=c++17 -DNDEBUG $flags -I"$root" \
+  "$root/bench/mk_freeverb_bench.cpp" "$root"/*.cpp -o "$bench" -lpthread
+
+runs=""
+for combs in 1 2 3 4 5 6 7 8; do
+  for predelay in 0 1; do
+    for crossfade in 0 1; do
+      [ $predelay -eq 0 ] && [ $crossfade -eq 1 ] && continue
+      for filter in 0 1; do
+        name="combs${combs}_predelay${predelay}_crossfade${crossfade}_filter${filter}"
+        features=$((predelay + 2 * crossfade + 4 * filter))
+        echo "== $name" >&2
+        "$bench" --combs=$combs --features=$features --out="$out/$name.json" "$@"
+        runs="$runs $out/$name.json"
+      done
+    done
+  done
+done
+rm -f "$bench"
+
+{
+  echo "{ \"runs\": ["
+  sep=""
+  for f in $runs; do
+    printf '%s' "$sep"
+    cat "$f"
+    sep=","
+  done
+  echo "] }"
+} > "$out/matrix.json"
+
+echo "wrote $out/matrix.json" >&2
@@ -12,16 +12,80 @@ comb::comb()
 	bufidx = 0;
 }
 
-void comb::setbuffer(float *buf, int size) 
+void comb::setbuffer(delay_sample *buf, int size) 
 {
 	buffer = buf; 
 	bufsize = size;
+	bufidx = 0;
+}
+
+// Block versions of process(). The work is split at the ring buffer wrap
+// point so the inner loop has no index check; within one run every sample
+// reads and writes its own buffer slot, so delay_run() can convert 16-bit
+// lines a chunk at a time. process_block replaces out, processmix_block
+// adds into it.
+
+void comb::process_block(const float *inp, float *out, int n)
+{
+	while (n > 0)
+	{
+		int len = bufsize-bufidx;
+		if (len > n) len = n;
+
+		float store = filterstore;
+		delay_run(buffer+bufidx, len, [&](float *buf, int pos, int count)
+		{
+			for (int i=0; i<count; i++)
+			{
+				float output = undenormalised(buf[i]);
+				store = undenormalised((output*damp2) + (store*damp1));
+				buf[i] = inp[pos+i] + (store*feedback);
+				out[pos+i] = output;
+			}
+		});
+		filterstore = store;
+
+		bufidx += len;
+		if (bufidx>=bufsize) bufidx = 0;
+		inp += len;
+		out += len;
+		n -= len;
+	}
+}
+
+void comb::processmix_block(const float *inp, float *out, int n)
+{
+	while (n > 0)
+	{
+		int len = bufsize-bufidx;
+		if (len > n) len = n;
+
+		float store = filterstore;
+		delay_run(buffer+bufidx, len, [&](float *buf, int pos, int count)
+		{
+			for (int i=0; i<count; i++)
+			{
+				float output = undenormalised(buf[i]);
+				store = undenormalised((output*damp2) + (store*damp1));
+				buf[i] = inp[pos+i] + (store*feedback);
+				out[pos+i] += output;
+			}
+		});
+		filterstore = store;
+
+		bufidx += len;
+		if (bufidx>=bufsize) bufidx = 0;
+		inp += len;
+		out += len;
+		n -= len;
+	}
 }
 
 void comb::mute()
 {
 	for (int i=0; i<bufsize; i++)
 		buffer[i]=0;
+	filterstore=0;
 }
 
 void comb::setdamp(float val) 
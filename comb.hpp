@@ -8,13 +8,16 @@
 #define _comb_
 
 #include "denormals.h"
+#include "delay_storage.h"
 
 class comb
 {
 public:
 					comb();
-			void	setbuffer(float *buf, int size);
+			void	setbuffer(delay_sample *buf, int size);
 	inline  float	process(float inp);
+			void	process_block(const float *inp, float *out, int n);
+			void	processmix_block(const float *inp, float *out, int n);
 			void	mute();
 			void	setdamp(float val);
 			float	getdamp();
@@ -25,7 +28,7 @@ private:
 	float	filterstore;
 	float	damp1;
 	float	damp2;
-	float	*buffer;
+	delay_sample	*buffer;
 	int		bufsize;
 	int		bufidx;
 };
@@ -37,13 +40,13 @@ inline float comb::process(float input)
 {
 	float output;
 
-	output = buffer[bufidx];
+	output = delay_read(buffer[bufidx]);
 	undenormalise(output);
 
 	filterstore = (output*damp2) + (filterstore*damp1);
 	undenormalise(filterstore);
 
-	buffer[bufidx] = input + (filterstore*feedback);
+	buffer[bufidx] = delay_write(input + (filterstore*feedback));
 
 	if(++bufidx>=bufsize) bufidx = 0;
 
@@ -0,0 +1,207 @@
+// Comb filter bank declaration
+//
+// Structure-of-arrays version of comb: the state of every left and right
+// comb lives in its own lane, so the lowpass and feedback updates of one
+// sample run as a handful of vector operations instead of numcombs*2
+// scalar calls. Lanes 0..numcombs-1 are the left combs, lanes
+// numcombs..numcombs*2-1 the right combs, the rest is zero padding.
+
+#ifndef _comb_bank_
+#define _comb_bank_
+
+#include "denormals.h"
+#include "simd.h"
+#include "delay_storage.h"
+
+template <int numcombs>
+class comb_bank
+{
+public:
+	enum { numlanes = numcombs*2, lanes = MK_FREEVERB_SIMD_ROUNDUP(numcombs*2) };
+
+					comb_bank();
+			void	setbuffer(int lane, delay_sample *buf, int size);
+	inline	void	process(float inp, float &outL, float &outR);
+			void	process_block(const float *inp, float *outL, float *outR, int n);
+			void	process_channel_block(int channel, const float *inp, float *out, int n);
+			void	mute();
+			void	setdamp(float val);
+			float	getdamp();
+			void	setfeedback(float val);
+			float	getfeedback();
+private:
+	inline	void	filter_lanes(float inp);
+
+	alignas(32) float	feedback[lanes];
+	alignas(32) float	filterstore[lanes];
+	alignas(32) float	damp1[lanes];
+	alignas(32) float	damp2[lanes];
+	alignas(32) float	output[lanes];
+	alignas(32) float	write[lanes];
+	delay_sample	*buffer[numlanes];
+	int		bufsize[numlanes];
+	int		bufidx[numlanes];
+};
+
+template <int numcombs>
+comb_bank<numcombs>::comb_bank()
+{
+	for (int i=0; i<lanes; i++)
+	{
+		feedback[i] = 0;
+		filterstore[i] = 0;
+		damp1[i] = 0;
+		damp2[i] = 0;
+		output[i] = 0;
+		write[i] = 0;
+	}
+	for (int i=0; i<numlanes; i++)
+	{
+		buffer[i] = 0;
+		bufsize[i] = 0;
+		bufidx[i] = 0;
+	}
+}
+
+template <int numcombs>
+void comb_bank<numcombs>::setbuffer(int lane, delay_sample *buf, int size)
+{
+	buffer[lane] = buf;
+	bufsize[lane] = size;
+	bufidx[lane] = 0;
+}
+
+template <int numcombs>
+void comb_bank<numcombs>::mute()
+{
+	for (int i=0; i<numlanes; i++)
+		for (int j=0; j<bufsize[i]; j++)
+			buffer[i][j]=0;
+	for (int i=0; i<lanes; i++)
+		filterstore[i]=0;
+}
+
+template <int numcombs>
+void comb_bank<numcombs>::setdamp(float val)
+{
+	for (int i=0; i<numlanes; i++)
+	{
+		damp1[i] = val;
+		damp2[i] = 1-val;
+	}
+}
+
+template <int numcombs>
+float comb_bank<numcombs>::getdamp()
+{
+	return damp1[0];
+}
+
+template <int numcombs>
+void comb_bank<numcombs>::setfeedback(float val)
+{
+	for (int i=0; i<numlanes; i++)
+		feedback[i] = val;
+}
+
+template <int numcombs>
+float comb_bank<numcombs>::getfeedback()
+{
+	return feedback[0];
+}
+
+// Lowpass and feedback update for all lanes. Same arithmetic as
+// comb::process, so every backend matches the scalar comb bit for bit.
+
+template <int numcombs>
+inline void comb_bank<numcombs>::filter_lanes(float inp)
+{
+	const simd_float in = simd_set1(inp);
+	for (int i=0; i<lanes; i+=MK_FREEVERB_SIMD_WIDTH)
+	{
+		simd_float out = simd_undenormalise(simd_load(output+i));
+		simd_store(output+i, out);
+
+		simd_float store = simd_add(simd_mul(out, simd_load(damp2+i)),
+									simd_mul(simd_load(filterstore+i), simd_load(damp1+i)));
+		store = simd_undenormalise(store);
+		simd_store(filterstore+i, store);
+
+		simd_store(write+i, simd_add(in, simd_mul(store, simd_load(feedback+i))));
+	}
+}
+
+// Big to inline - but crucial for speed
+
+template <int numcombs>
+inline void comb_bank<numcombs>::process(float input, float &outL, float &outR)
+{
+	for (int i=0; i<numlanes; i++)
+		output[i] = delay_read(buffer[i][bufidx[i]]);
+
+	filter_lanes(input);
+
+	for (int i=0; i<numlanes; i++)
+	{
+		buffer[i][bufidx[i]] = delay_write(write[i]);
+		int next = bufidx[i]+1;
+		bufidx[i] = (next>=bufsize[i]) ? 0 : next;
+	}
+
+	// Sum in comb order, matching the scalar outL += comb[i].process() loop
+	float sumL = 0, sumR = 0;
+	for (int i=0; i<numcombs; i++)
+		sumL += output[i];
+	for (int i=numcombs; i<numlanes; i++)
+		sumR += output[i];
+
+	outL = sumL;
+	outR = sumR;
+}
+
+template <int numcombs>
+void comb_bank<numcombs>::process_block(const float *inp, float *outL, float *outR, int n)
+{
+	for (int i=0; i<n; i++)
+		process(inp[i], outL[i], outR[i]);
+}
+
+// The combs of one channel (0 = left, 1 = right) only, one lane after the
+// other, summed in comb order like process(). Lanes of the other channel
+// are not touched, so both channels can run on different threads.
+
+template <int numcombs>
+void comb_bank<numcombs>::process_channel_block(int channel, const float *inp, float *out, int n)
+{
+	for (int i=0; i<n; i++)
+		out[i] = 0;
+
+	for (int lane=channel*numcombs; lane<(channel+1)*numcombs; lane++)
+	{
+		delay_sample	*buf = buffer[lane];
+		int		size = bufsize[lane];
+		int		idx = bufidx[lane];
+		float	store = filterstore[lane];
+
+		for (int i=0; i<n; i++)
+		{
+			float output = delay_read(buf[idx]);
+			undenormalise(output);
+
+			store = (output*damp2[lane]) + (store*damp1[lane]);
+			undenormalise(store);
+
+			buf[idx] = delay_write(inp[i] + (store*feedback[lane]));
+			if(++idx>=size) idx = 0;
+
+			out[i] += output;
+		}
+
+		filterstore[lane] = store;
+		bufidx[lane] = idx;
+	}
+}
+
+#endif//_comb_bank_
+
+//ends
@@ -0,0 +1,139 @@
+// Fixed-point comb filter declaration
+//
+// Same structure as comb, with sample_t = int16_t (Q15) or int32_t (Q31)
+// samples and delay lines. Coefficients keep one integer bit, so the
+// feedback of 1 and undamped lowpass used by freeze mode are exact.
+
+#ifndef _comb_fixed_
+#define _comb_fixed_
+
+#include "fixed.h"
+
+template <typename sample_t>
+class comb_fixed
+{
+public:
+	enum { coefbits = fixed_format<sample_t>::fracbits-1 };
+
+					comb_fixed();
+			void	setbuffer(sample_t *buf, int size);
+	inline  sample_t	process(sample_t inp);
+			void	processmix_block(const sample_t *inp, sample_t *out, int n);
+			void	mute();
+			void	setdamp(float val);
+			float	getdamp();
+			void	setfeedback(float val);
+			float	getfeedback();
+private:
+	sample_t	feedback;
+	sample_t	filterstore;
+	sample_t	damp1;
+	sample_t	damp2;
+	float		dampvalue;
+	float		feedbackvalue;
+	sample_t	*buffer;
+	int			bufsize;
+	int			bufidx;
+};
+
+template <typename sample_t>
+comb_fixed<sample_t>::comb_fixed()
+{
+	feedback = filterstore = damp1 = damp2 = 0;
+	dampvalue = feedbackvalue = 0;
+	buffer = 0;
+	bufsize = 0;
+	bufidx = 0;
+}
+
+template <typename sample_t>
+void comb_fixed<sample_t>::setbuffer(sample_t *buf, int size)
+{
+	buffer = buf;
+	bufsize = size;
+	bufidx = 0;
+}
+
+// Big to inline - but crucial for speed
+
+template <typename sample_t>
+inline sample_t comb_fixed<sample_t>::process(sample_t input)
+{
+	sample_t output = buffer[bufidx];
+
+	filterstore = fixed_mac2(output, damp2, filterstore, damp1, coefbits);
+	buffer[bufidx] = fixed_add(input, fixed_mul(filterstore, feedback, coefbits));
+
+	if(++bufidx>=bufsize) bufidx = 0;
+
+	return output;
+}
+
+// Adds the comb output to out. Split at the ring buffer wrap point like
+// comb::processmix_block.
+
+template <typename sample_t>
+void comb_fixed<sample_t>::processmix_block(const sample_t *inp, sample_t *out, int n)
+{
+	while (n > 0)
+	{
+		int len = bufsize-bufidx;
+		if (len > n) len = n;
+
+		sample_t *buf = buffer+bufidx;
+		sample_t store = filterstore;
+		for (int i=0; i<len; i++)
+		{
+			sample_t output = buf[i];
+			store = fixed_mac2(output, damp2, store, damp1, coefbits);
+			buf[i] = fixed_add(inp[i], fixed_mul(store, feedback, coefbits));
+			out[i] = fixed_add(out[i], output);
+		}
+		filterstore = store;
+
+		bufidx += len;
+		if (bufidx>=bufsize) bufidx = 0;
+		inp += len;
+		out += len;
+		n -= len;
+	}
+}
+
+template <typename sample_t>
+void comb_fixed<sample_t>::mute()
+{
+	for (int i=0; i<bufsize; i++)
+		buffer[i]=0;
+	filterstore=0;
+}
+
+template <typename sample_t>
+void comb_fixed<sample_t>::setdamp(float val)
+{
+	dampvalue = val;
+	damp1 = fixed_from_float<sample_t>(val, coefbits);
+	damp2 = fixed_from_float<sample_t>(1-val, coefbits);
+}
+
+template <typename sample_t>
+float comb_fixed<sample_t>::getdamp()
+{
+	return dampvalue;
+}
+
+template <typename sample_t>
+void comb_fixed<sample_t>::setfeedback(float val)
+{
+	feedbackvalue = val;
+	feedback = fixed_from_float<sample_t>(val, coefbits);
+}
+
+template <typename sample_t>
+float comb_fixed<sample_t>::getfeedback()
+{
+	return feedbackvalue;
+}
+
+#endif//_comb_fixed_
+
+//ends
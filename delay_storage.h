@@ -0,0 +1,285 @@
+// Sample format of the comb and allpass delay lines
+//
+// delay_sample is the type stored in the lines, chosen by
+// MK_FREEVERB_DELAY_STORAGE. All filtering stays in float; the helpers
+// below convert on the way in and out:
+//
+//   delay_read/delay_write              one sample
+//   simd_delay_load/simd_delay_store    MK_FREEVERB_SIMD_WIDTH samples,
+//                                       any alignment for 16-bit lines
+//   delay_run                           a block kernel over a run of a line
+//
+// Every backend rounds to nearest even, so the SIMD and scalar paths store
+// the same bits. With float storage all of them are plain loads and stores.
+
+#ifndef _mk_freeverb_delay_storage_
+#define _mk_freeverb_delay_storage_
+
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include "simd.h"
+
+#if MK_FREEVERB_DELAY_STORAGE == MK_FREEVERB_DELAY_FP16
+#if defined(__F16C__) && (MK_FREEVERB_SIMD_AVX || MK_FREEVERB_SIMD_SSE)
+#include <immintrin.h>
+#define MK_FREEVERB_DELAY_F16C	1
+#elif MK_FREEVERB_SIMD_NEON && (defined(__aarch64__) || \
+	  (defined(__ARM_FP) && (__ARM_FP & 2) && defined(__ARM_FP16_FORMAT_IEEE)))
+#define MK_FREEVERB_DELAY_NEON_FP16	1
+#endif
+#endif
+
+#if MK_FREEVERB_DELAY_STORAGE == MK_FREEVERB_DELAY_FLOAT
+
+typedef float delay_sample;
+
+static inline float delay_read(delay_sample v) { return v; }
+static inline delay_sample delay_write(float v) { return v; }
+static inline simd_float simd_delay_load(const delay_sample *p) { return simd_load(p); }
+static inline void simd_delay_store(delay_sample *p, simd_float v) { simd_store(p, v); }
+#define MK_FREEVERB_DELAY_VECTOR	1
+
+#elif MK_FREEVERB_DELAY_STORAGE == MK_FREEVERB_DELAY_INT16
+
+typedef int16_t delay_sample;
+
+static const float delay_int16_scale = 32768.0f / MK_FREEVERB_DELAY_INT16_RANGE;
+static const float delay_int16_unscale = MK_FREEVERB_DELAY_INT16_RANGE / 32768.0f;
+
+static inline float delay_read(delay_sample v)
+{
+	return v * delay_int16_unscale;
+}
+
+static inline delay_sample delay_write(float v)
+{
+	float s = v * delay_int16_scale;
+	s = s > 32767.0f ? 32767.0f : s;
+	s = s < -32768.0f ? -32768.0f : s;
+#if MK_FREEVERB_SIMD_AVX || MK_FREEVERB_SIMD_SSE
+	return (delay_sample)_mm_cvtss_si32(_mm_set_ss(s));
+#else
+	return (delay_sample)lrintf(s);
+#endif
+}
+
+#if MK_FREEVERB_SIMD_AVX
+static inline __m128 delay_int16_widen(__m128i v)
+{
+	return _mm_cvtepi32_ps(_mm_srai_epi32(v, 16));
+}
+static inline simd_float simd_delay_load(const delay_sample *p)
+{
+	__m128i v = _mm_loadu_si128((const __m128i *)p);
+	__m256 f = _mm256_insertf128_ps(_mm256_castps128_ps256(delay_int16_widen(_mm_unpacklo_epi16(v, v))),
+									delay_int16_widen(_mm_unpackhi_epi16(v, v)), 1);
+	return _mm256_mul_ps(f, _mm256_set1_ps(delay_int16_unscale));
+}
+static inline void simd_delay_store(delay_sample *p, simd_float v)
+{
+	v = _mm256_mul_ps(v, _mm256_set1_ps(delay_int16_scale));
+	v = _mm256_max_ps(_mm256_min_ps(v, _mm256_set1_ps(32767.0f)), _mm256_set1_ps(-32768.0f));
+	__m256i i = _mm256_cvtps_epi32(v);
+	_mm_storeu_si128((__m128i *)p, _mm_packs_epi32(_mm256_castsi256_si128(i), _mm256_extractf128_si256(i, 1)));
+}
+#define MK_FREEVERB_DELAY_VECTOR	1
+#elif MK_FREEVERB_SIMD_SSE
+static inline simd_float simd_delay_load(const delay_sample *p)
+{
+	__m128i v = _mm_loadl_epi64((const __m128i *)p);
+	__m128 f = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16));
+	return _mm_mul_ps(f, _mm_set1_ps(delay_int16_unscale));
+}
+static inline void simd_delay_store(delay_sample *p, simd_float v)
+{
+	v = _mm_mul_ps(v, _mm_set1_ps(delay_int16_scale));
+	v = _mm_max_ps(_mm_min_ps(v, _mm_set1_ps(32767.0f)), _mm_set1_ps(-32768.0f));
+	__m128i i = _mm_cvtps_epi32(v);
+	_mm_storel_epi64((__m128i *)p, _mm_packs_epi32(i, i));
+}
+#define MK_FREEVERB_DELAY_VECTOR	1
+#elif MK_FREEVERB_SIMD_NEON && defined(__aarch64__)
+static inline simd_float simd_delay_load(const delay_sample *p)
+{
+	return vmulq_f32(vcvtq_f32_s32(vmovl_s16(vld1_s16(p))), vdupq_n_f32(delay_int16_unscale));
+}
+static inline void simd_delay_store(delay_sample *p, simd_float v)
+{
+	v = vmulq_f32(v, vdupq_n_f32(delay_int16_scale));
+	v = vmaxq_f32(vminq_f32(v, vdupq_n_f32(32767.0f)), vdupq_n_f32(-32768.0f));
+	vst1_s16(p, vqmovn_s32(vcvtnq_s32_f32(v)));
+}
+#define MK_FREEVERB_DELAY_VECTOR	1
+#endif
+
+#elif MK_FREEVERB_DELAY_STORAGE == MK_FREEVERB_DELAY_FP16
+
+typedef uint16_t delay_sample;
+
+#if MK_FREEVERB_DELAY_F16C
+static inline float delay_read(delay_sample v) { return _cvtsh_ss(v); }
+static inline delay_sample delay_write(float v) { return _cvtss_sh(v, 0); }
+#if MK_FREEVERB_SIMD_AVX
+static inline simd_float simd_delay_load(const delay_sample *p)
+{
+	return _mm256_cvtph_ps(_mm_loadu_si128((const __m128i *)p));
+}
+static inline void simd_delay_store(delay_sample *p, simd_float v)
+{
+	_mm_storeu_si128((__m128i *)p, _mm256_cvtps_ph(v, 0));
+}
+#else
+static inline simd_float simd_delay_load(const delay_sample *p)
+{
+	return _mm_cvtph_ps(_mm_loadl_epi64((const __m128i *)p));
+}
+static inline void simd_delay_store(delay_sample *p, simd_float v)
+{
+	_mm_storel_epi64((__m128i *)p, _mm_cvtps_ph(v, 0));
+}
+#endif
+#define MK_FREEVERB_DELAY_VECTOR	1
+#elif MK_FREEVERB_DELAY_NEON_FP16
+static inline simd_float simd_delay_load(const delay_sample *p)
+{
+	return vcvt_f32_f16(vreinterpret_f16_u16(vld1_u16(p)));
+}
+static inline void simd_delay_store(delay_sample *p, simd_float v)
+{
+	vst1_u16(p, vreinterpret_u16_f16(vcvt_f16_f32(v)));
+}
+static inline float delay_read(delay_sample v)
+{
+	return vgetq_lane_f32(vcvt_f32_f16(vreinterpret_f16_u16(vdup_n_u16(v))), 0);
+}
+static inline delay_sample delay_write(float v)
+{
+	return vget_lane_u16(vreinterpret_u16_f16(vcvt_f16_f32(vdupq_n_f32(v))), 0);
+}
+#define MK_FREEVERB_DELAY_VECTOR	1
+#else
+// Portable conversions, including subnormal halves
+static inline float delay_read(delay_sample v)
+{
+	uint32_t sign = (uint32_t)(v & 0x8000) << 16;
+	uint32_t exp = (v >> 10) & 0x1f;
+	uint32_t mant = v & 0x3ff;
+	uint32_t bits;
+	if (exp == 0x1f)
+		bits = sign | 0x7f800000 | (mant << 13);
+	else if (exp != 0)
+		bits = sign | ((exp + 112) << 23) | (mant << 13);
+	else if (mant == 0)
+		bits = sign;
+	else
+	{
+		exp = 113;
+		while (!(mant & 0x400)) { mant <<= 1; exp--; }
+		bits = sign | (exp << 23) | ((mant & 0x3ff) << 13);
+	}
+	float f;
+	memcpy(&f, &bits, sizeof(f));
+	return f;
+}
+
+static inline delay_sample delay_write(float f)
+{
+	uint32_t bits;
+	memcpy(&bits, &f, sizeof(bits));
+	uint32_t sign = (bits >> 16) & 0x8000;
+	uint32_t abs = bits & 0x7fffffff;
+
+	if (abs >= 0x7f800000)			// inf, nan
+		return (delay_sample)(sign | 0x7c00 | (abs > 0x7f800000 ? 0x200 : 0));
+	if (abs >= 0x477ff000)			// rounds past 65504
+		return (delay_sample)(sign | 0x7c00);
+	if (abs < 0x33000000)			// below half the smallest subnormal
+		return (delay_sample)sign;
+
+	uint32_t h, rem, halfway;
+	if (abs < 0x38800000)
+	{
+		// Subnormal half
+		uint32_t mant = (abs & 0x7fffff) | 0x800000;
+		int shift = 126 - (int)(abs >> 23);
+		h = mant >> shift;
+		rem = mant & ((1u << shift) - 1);
+		halfway = 1u << (shift - 1);
+	}
+	else
+	{
+		h = (abs >> 13) - (112 << 10);
+		rem = abs & 0x1fff;
+		halfway = 0x1000;
+	}
+	if (rem > halfway || (rem == halfway && (h & 1)))
+		h++;
+	return (delay_sample)(sign | h);
+}
+#endif
+
+#else
+#error "unknown MK_FREEVERB_DELAY_STORAGE"
+#endif
+
+// Lane by lane fallback for 16-bit lines without a vector conversion
+#if !MK_FREEVERB_DELAY_VECTOR
+static inline simd_float simd_delay_load(const delay_sample *p)
+{
+	alignas(32) float v[MK_FREEVERB_SIMD_WIDTH];
+	for (int i=0; i<MK_FREEVERB_SIMD_WIDTH; i++) v[i] = delay_read(p[i]);
+	return simd_load(v);
+}
+static inline void simd_delay_store(delay_sample *p, simd_float f)
+{
+	alignas(32) float v[MK_FREEVERB_SIMD_WIDTH];
+	simd_store(v, f);
+	for (int i=0; i<MK_FREEVERB_SIMD_WIDTH; i++) p[i] = delay_write(v[i]);
+}
+#endif
+
+#ifdef __cplusplus
+
+// Samples expanded to float per delay_run() step
+const int delay_chunk = 64;
+
+// Runs kernel(float *line, int offset, int count) over n samples of a delay
+// line, offset being the position within the n. A float line is handed to
+// the kernel directly. A 16-bit line is expanded into a float scratch
+// chunk, processed in place and converted back, with vector conversions
+// for the whole vectors of each chunk.
+template <typename kernel_t>
+static inline void delay_run(delay_sample *line, int n, kernel_t kernel)
+{
+#if MK_FREEVERB_DELAY_STORAGE == MK_FREEVERB_DELAY_FLOAT
+	kernel(line, 0, n);
+#else
+	alignas(32) float scratch[delay_chunk];
+	for (int pos=0; pos<n; pos+=delay_chunk)
+	{
+		int count = n-pos < delay_chunk ? n-pos : delay_chunk;
+		delay_sample *src = line+pos;
+
+		int i = 0;
+		for (; i+MK_FREEVERB_SIMD_WIDTH<=count; i+=MK_FREEVERB_SIMD_WIDTH)
+			simd_store(scratch+i, simd_delay_load(src+i));
+		for (; i<count; i++)
+			scratch[i] = delay_read(src[i]);
+
+		kernel(scratch, pos, count);
+
+		i = 0;
+		for (; i+MK_FREEVERB_SIMD_WIDTH<=count; i+=MK_FREEVERB_SIMD_WIDTH)
+			simd_delay_store(src+i, simd_load(scratch+i));
+		for (; i<count; i++)
+			src[i] = delay_write(scratch[i]);
+	}
+#endif
+}
+
+#endif
+
+#endif//_mk_freeverb_delay_storage_
+
+//ends
@@ -8,7 +8,96 @@
 #ifndef _denormals_
 #define _denormals_
 
-#define undenormalise(sample) if(((*(unsigned int*)&sample)&0x7f800000)==0) sample=0.0f
+#include <string.h>
+#include "mk_freeverb_config.h"
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#endif
+
+#if MK_FREEVERB_ENABLE_STATS && defined(__cplusplus)
+// Samples undenormalise has flushed on this thread, for mk_freeverb_stats.
+// Only counted in MK_FREEVERB_DENORMALS_CHECK mode.
+inline thread_local unsigned long long mk_freeverb_denormal_hits = 0;
+
+static inline void mk_freeverb_count_denormal(float sample)
+{
+	unsigned int bits;
+	memcpy(&bits, &sample, sizeof(bits));
+	mk_freeverb_denormal_hits += !(bits&0x7f800000) && (bits&0x007fffff);
+}
+#endif
+
+// Returns 0 for denormalled (and zero) samples, the sample otherwise.
+// Reads the bits through memcpy and selects instead of branching, so
+// block loops stay free of jumps. With hardware flush-to-zero or the
+// anti-denormal offset (MK_FREEVERB_DENORMAL_MODE) the check compiles out.
+static inline float undenormalised(float sample)
+{
+#if MK_FREEVERB_DENORMAL_MODE == MK_FREEVERB_DENORMALS_CHECK
+	unsigned int bits;
+	memcpy(&bits, &sample, sizeof(bits));
+#if MK_FREEVERB_ENABLE_STATS && defined(__cplusplus)
+	mk_freeverb_count_denormal(sample);
+#endif
+	return (bits&0x7f800000) ? sample : 0.0f;
+#else
+	return sample;
+#endif
+}
+
+#define undenormalise(sample) sample = undenormalised(sample)
+
+// Tiny DC offset added to the reverb input in MK_FREEVERB_DENORMALS_OFFSET
+// mode. It keeps every filter state far above the denormal range
+// (~1e-38) while staying ~340 dB below full scale.
+const float antidenormal = 1e-17f;
+
+#ifdef __cplusplus
+
+// Enables flush-to-zero/denormals-are-zero for the current thread and
+// restores the previous mode on destruction: MXCSR FTZ|DAZ on x86,
+// FPCR.FZ on AArch64, FPSCR.FZ on 32-bit ARM. Does nothing elsewhere.
+class denormal_guard
+{
+public:
+	denormal_guard()
+	{
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+		saved = _mm_getcsr();
+		_mm_setcsr(saved | 0x8040);
+#elif defined(__aarch64__) && defined(__GNUC__)
+		__asm__ __volatile__("mrs %0, fpcr" : "=r"(saved));
+		__asm__ __volatile__("msr fpcr, %0" : : "r"(saved | (1ull << 24)));
+#elif defined(__arm__) && defined(__ARM_FP) && defined(__GNUC__)
+		__asm__ __volatile__("vmrs %0, fpscr" : "=r"(saved));
+		__asm__ __volatile__("vmsr fpscr, %0" : : "r"(saved | (1u << 24)));
+#endif
+	}
+
+	~denormal_guard()
+	{
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+		_mm_setcsr(saved);
+#elif defined(__aarch64__) && defined(__GNUC__)
+		__asm__ __volatile__("msr fpcr, %0" : : "r"(saved));
+#elif defined(__arm__) && defined(__ARM_FP) && defined(__GNUC__)
+		__asm__ __volatile__("vmsr fpscr, %0" : : "r"(saved));
+#endif
+	}
+
+	denormal_guard(const denormal_guard&) = delete;
+	denormal_guard& operator=(const denormal_guard&) = delete;
+
+private:
+#if defined(__aarch64__)
+	unsigned long long saved = 0;
+#else
+	unsigned int saved = 0;
+#endif
+};
+
+#endif
 
 #endif//_denormals_
 
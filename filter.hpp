@@ -3,6 +3,7 @@
 
 #include <cmath>
 #include <algorithm>
+#include "simd.h"
 
 // Simple biquad filter for reverb input processing
 // Uses same algorithms as liquidsfz for consistency
@@ -15,6 +16,40 @@ public:
         Highpass
     };
 
+    // Fast dB to factor conversion (same as liquidsfz)
+    static float fast_db_to_factor(float db) {
+        return exp2f(db * 0.166096404744368f);
+    }
+
+    // Prewarped cutoff k = tan(pi * fc / fs) of the 2 pole design
+    static float prewarp(float cutoff, float sample_rate) {
+        // Same math as liquidsfz: normalize cutoff by sample rate
+        float norm_cutoff = std::min(cutoff / sample_rate, 0.49f);
+        return tanf(M_PI * norm_cutoff);
+    }
+
+    // 2 pole design from DAFX 2nd ed., Zoelzer (same as liquidsfz)
+    // k from prewarp(), q from fast_db_to_factor(resonance)
+    static void design(Type type, float k, float q, float &b0, float &b1, float &b2, float &a1, float &a2) {
+        const float kk = k * k;
+        const float div_factor = 1.0f / (1.0f + (k + 1.0f / q) * k);
+
+        a1 = 2.0f * (kk - 1.0f) * div_factor;
+        a2 = (1.0f - k / q + kk) * div_factor;
+
+        if (type == Lowpass) {
+            b0 = kk * div_factor;
+            b1 = 2.0f * b0;
+            b2 = b0;
+        } else if (type == Highpass) {
+            b0 = div_factor;
+            b1 = -2.0f * div_factor;
+            b2 = div_factor;
+        } else {
+            b0 = 1.0f; b1 = b2 = a1 = a2 = 0.0f;
+        }
+    }
+
     Filter(Type type = NONE, float sample_rate = 48000.0f) : type_(type), sample_rate_(sample_rate) {
         x1_ = x2_ = y1_ = y2_ = 0.0f;
         first_ = true;
@@ -72,11 +107,6 @@ public:
     }
 
 private:
-    // Fast dB to factor conversion (same as liquidsfz)
-    float fast_db_to_factor(float db) {
-        return exp2f(db * 0.166096404744368f);
-    }
-
     void update_coefficients() {
         if (enabled_ == false)
             return;
@@ -110,29 +140,7 @@ private:
         last_cutoff_ = cutoff;
         last_resonance_ = resonance;
 
-        // Same math as liquidsfz: normalize cutoff by sample rate
-        float norm_cutoff = std::min(cutoff / sample_rate_, 0.49f);
-
-        // 2 pole design from DAFX 2nd ed., Zoelzer (same as liquidsfz)
-        const float k = tanf(M_PI * norm_cutoff);
-        const float kk = k * k;
-        const float q = fast_db_to_factor(resonance);  // Convert dB to linear (same as liquidsfz)
-        const float div_factor = 1.0f / (1.0f + (k + 1.0f / q) * k);
-
-        a1_ = 2.0f * (kk - 1.0f) * div_factor;
-        a2_ = (1.0f - k / q + kk) * div_factor;
-
-        if (type_ == Lowpass) {
-            b0_ = kk * div_factor;
-            b1_ = 2.0f * b0_;
-            b2_ = b0_;
-        } else if (type_ == Highpass) {
-            b0_ = div_factor;
-            b1_ = -2.0f * div_factor;
-            b2_ = div_factor;
-        } else {
-            b0_ = 1.0f; b1_ = b2_ = a1_ = a2_ = 0.0f;
-        }
+        design(type_, prewarp(cutoff, sample_rate_), fast_db_to_factor(resonance), b0_, b1_, b2_, a1_, a2_);
     }
 
     bool enabled_ = false;
@@ -155,4 +163,217 @@ private:
     float y1_ = 0.0f, y2_ = 0.0f;
 };
 
+// Stereo version of Filter for the reverb input: one coefficient set, a
+// separate delay line per channel. Both channels run as lanes 0 and 1 of
+// one simd_float, with the same operation order as Filter::process, so each
+// channel matches its own Filter bit for bit once the coefficients agree.
+//
+// setCutoff/setResonance only store the target. The liquidsfz smoothing
+// steps towards it every MK_FREEVERB_CONTROL_RATE samples inside
+// process(); tanf and exp2f run only for the parameter that moved and
+// nothing is redesigned once the target is reached.
+class StereoFilter
+{
+public:
+    StereoFilter(Filter::Type type = Filter::NONE, float sample_rate = 48000.0f) {
+        reset(type, sample_rate);
+    }
+
+    // Clears both channels; the next process() designs for the target directly
+    void reset(Filter::Type type, float sample_rate) {
+        type_ = type;
+        sample_rate_ = sample_rate;
+        enabled_ = (type != Filter::NONE && sample_rate > 0.0f);
+        first_ = true;
+        countdown_ = 0;
+        design_cutoff_ = design_resonance_ = -1.0f;
+        for (int i = 0; i < MK_FREEVERB_SIMD_WIDTH; i++) {
+            x1_[i] = x2_[i] = y1_[i] = y2_[i] = 0.0f;
+        }
+    }
+
+    // Clears both channels' delay lines; coefficients and smoothing stay
+    void mute() {
+        for (int i = 0; i < MK_FREEVERB_SIMD_WIDTH; i++) {
+            x1_[i] = x2_[i] = y1_[i] = y2_[i] = 0.0f;
+        }
+    }
+
+    Filter::Type getType() const {
+        return type_;
+    }
+
+    void setCutoff(float freq) {
+        cutoff_ = std::max(freq, 10.0f);  // Same as liquidsfz minimum
+    }
+
+    void setResonance(float res) {
+        resonance_ = res;
+    }
+
+    // Filters both channels in place
+    void process(float *left, float *right, int n) {
+        if (!enabled_) {
+            return;
+        }
+
+        while (n > 0) {
+            if (countdown_ == 0) {
+                update_coefficients();
+                countdown_ = MK_FREEVERB_CONTROL_RATE;
+            }
+            int len = n < countdown_ ? n : countdown_;
+            run(left, right, len);
+            countdown_ -= len;
+            left += len;
+            right += len;
+            n -= len;
+        }
+    }
+
+    // True when both channels hold the same state, so the same input
+    // gives the same output on both
+    bool channels_match() const {
+        return x1_[0] == x1_[1] && x2_[0] == x2_[1] && y1_[0] == y1_[1] && y2_[0] == y2_[1];
+    }
+
+    // Filters one signal fed to both channels, in place. Runs the left
+    // lane alone and copies its state to the right lane; with
+    // channels_match() the result and the following process() calls are
+    // the same as process(samples, copy, n)
+    void process_mono(float *samples, int n) {
+        if (!enabled_) {
+            return;
+        }
+
+        while (n > 0) {
+            if (countdown_ == 0) {
+                update_coefficients();
+                countdown_ = MK_FREEVERB_CONTROL_RATE;
+            }
+            int len = n < countdown_ ? n : countdown_;
+            run_mono(samples, len);
+            countdown_ -= len;
+            samples += len;
+            n -= len;
+        }
+        x1_[1] = x1_[0];
+        x2_[1] = x2_[0];
+        y1_[1] = y1_[0];
+        y2_[1] = y2_[0];
+    }
+
+private:
+    // Lane 0 of run() in scalar code, same operation order
+    void run_mono(float *samples, int n) {
+        float x1 = x1_[0], x2 = x2_[0];
+        float y1 = y1_[0], y2 = y2_[0];
+
+        for (int i = 0; i < n; i++) {
+            const float x = samples[i];
+            const float y = b0_ * x + b1_ * x1 + b2_ * x2 - a1_ * y1 - a2_ * y2;
+            samples[i] = y;
+
+            x2 = x1;
+            x1 = x;
+            y2 = y1;
+            y1 = y;
+        }
+
+        x1_[0] = x1;
+        x2_[0] = x2;
+        y1_[0] = y1;
+        y2_[0] = y2;
+    }
+
+    void run(float *left, float *right, int n) {
+        const simd_float b0 = simd_set1(b0_), b1 = simd_set1(b1_), b2 = simd_set1(b2_);
+        const simd_float a1 = simd_set1(a1_), a2 = simd_set1(a2_);
+        simd_float x1 = simd_load(x1_), x2 = simd_load(x2_);
+        simd_float y1 = simd_load(y1_), y2 = simd_load(y2_);
+
+        alignas(32) float frame[MK_FREEVERB_SIMD_WIDTH] = {};
+        for (int i = 0; i < n; i++) {
+            frame[0] = left[i];
+            frame[1] = right[i];
+            simd_float x = simd_load(frame);
+
+            simd_float y = simd_sub(simd_sub(simd_add(simd_add(simd_mul(b0, x), simd_mul(b1, x1)), simd_mul(b2, x2)),
+                                             simd_mul(a1, y1)), simd_mul(a2, y2));
+            simd_store(frame, y);
+            left[i] = frame[0];
+            right[i] = frame[1];
+
+            x2 = x1;
+            x1 = x;
+            y2 = y1;
+            y1 = y;
+        }
+
+        simd_store(x1_, x1);
+        simd_store(x2_, x2);
+        simd_store(y1_, y1);
+        simd_store(y2_, y2);
+    }
+
+    void update_coefficients() {
+        // Parameter smoothing (same logic as liquidsfz), one step per control period
+        float cutoff = cutoff_;
+        float resonance = resonance_;
+
+        if (first_) {
+            first_ = false;
+        } else if (cutoff == last_cutoff_ && resonance == last_resonance_) {
+            return;
+        } else {
+            const float cutoff_smooth = 1.2f;  // Same as liquidsfz for order 2
+            const float reso_smooth = 1.0f;
+
+            const float high = cutoff_smooth;
+            const float low = 1.0f / high;
+
+            cutoff = std::clamp(cutoff, last_cutoff_ * low, last_cutoff_ * high);
+            resonance = std::clamp(resonance, last_resonance_ - reso_smooth, last_resonance_ + reso_smooth);
+        }
+
+        last_cutoff_ = cutoff;
+        last_resonance_ = resonance;
+
+        // Coefficient cache: only redo the transcendental part that changed
+        if (cutoff != design_cutoff_) {
+            k_ = Filter::prewarp(cutoff, sample_rate_);
+            design_cutoff_ = cutoff;
+        }
+        if (resonance != design_resonance_) {
+            q_ = Filter::fast_db_to_factor(resonance);
+            design_resonance_ = resonance;
+        }
+        Filter::design(type_, k_, q_, b0_, b1_, b2_, a1_, a2_);
+    }
+
+    bool enabled_ = false;
+    Filter::Type type_ = Filter::NONE;
+    float sample_rate_ = 0.0f;
+    float cutoff_ = 1000.0f;
+    float resonance_ = 0.0f;  // In dB (same as liquidsfz)
+
+    // Parameter smoothing state
+    bool first_ = true;
+    int countdown_ = 0;
+    float last_cutoff_ = 10.0f;
+    float last_resonance_ = 0.0f;
+
+    // Coefficient cache: parameters k_ and q_ were computed for
+    float design_cutoff_ = -1.0f, design_resonance_ = -1.0f;
+    float k_ = 0.0f, q_ = 1.0f;
+
+    // Biquad coefficients
+    float b0_ = 1.0f, b1_ = 0.0f, b2_ = 0.0f;
+    float a1_ = 0.0f, a2_ = 0.0f;
+
+    // Delay line, lane 0 left, lane 1 right
+    alignas(32) float x1_[MK_FREEVERB_SIMD_WIDTH], x2_[MK_FREEVERB_SIMD_WIDTH];
+    alignas(32) float y1_[MK_FREEVERB_SIMD_WIDTH], y2_[MK_FREEVERB_SIMD_WIDTH];
+};
+
 #endif // MK_FREEVERB_FILTER_HPP
\ No newline at end of file
@@ -0,0 +1,135 @@
+#ifndef MK_FREEVERB_FILTER_FIXED_HPP
+#define MK_FREEVERB_FILTER_FIXED_HPP
+
+#include "filter.hpp"
+#include "fixed.h"
+
+// Fixed-point version of Filter for Q15 (int16_t) or Q31 (int32_t) samples
+// The coefficients come from the float Filter design (same liquidsfz math)
+// and are quantized to Q2.29 so the |a1| < 2 and b1 = +-2*b0 terms fit.
+// Direct form I with a 64-bit accumulator; the output is saturated and
+// its rounding error fed into the next sample (first-order error
+// feedback). Plain rounding leaves a deadband at low cutoffs, where the
+// poles sit close to 1: at 200 Hz and 48 kHz the output could hold a DC
+// offset of several hundred Q15 steps after the input stops.
+//
+// Like StereoFilter, setCutoff/setResonance only store the target and the
+// liquidsfz smoothing takes one step towards it every
+// MK_FREEVERB_CONTROL_RATE samples inside process(), so the coefficients
+// follow the float input filter step for step. Floats are only touched
+// while a parameter is still moving.
+template <typename sample_t>
+class FixedFilter
+{
+public:
+    enum { coefbits = 29 };
+
+    FixedFilter(Filter::Type type = Filter::NONE, float sample_rate = 48000.0f) {
+        reset(type, sample_rate);
+    }
+
+    // Clears the state; the next process() designs for the target directly
+    void reset(Filter::Type type, float sample_rate) {
+        type_ = type;
+        sample_rate_ = sample_rate;
+        enabled_ = (type != Filter::NONE && sample_rate > 0.0f);
+        first_ = true;
+        countdown_ = 0;
+        x1_ = x2_ = y1_ = y2_ = 0;
+        error_ = 0;
+    }
+
+    Filter::Type getType() const {
+        return type_;
+    }
+
+    void setCutoff(float freq) {
+        cutoff_ = std::max(freq, 10.0f);  // Same as liquidsfz minimum
+    }
+
+    void setResonance(float res) {
+        resonance_ = res;
+    }
+
+    sample_t process(sample_t input) {
+        if (!enabled_) {
+            return input;
+        }
+
+        if (countdown_ == 0) {
+            update_coefficients();
+            countdown_ = MK_FREEVERB_CONTROL_RATE;
+        }
+        countdown_--;
+
+        int64_t acc = static_cast<int64_t>(b0_) * input + static_cast<int64_t>(b1_) * x1_ + static_cast<int64_t>(b2_) * x2_
+                    - static_cast<int64_t>(a1_) * y1_ - static_cast<int64_t>(a2_) * y2_ + error_;
+        sample_t output = fixed_saturate<sample_t>(acc >> coefbits);
+        error_ = acc & ((static_cast<int64_t>(1) << coefbits) - 1);
+
+        // Shift delay line
+        x2_ = x1_;
+        x1_ = input;
+        y2_ = y1_;
+        y1_ = output;
+
+        return output;
+    }
+
+private:
+    void update_coefficients() {
+        // Parameter smoothing (same logic as liquidsfz), one step per control period
+        float cutoff = cutoff_;
+        float resonance = resonance_;
+
+        if (first_) {
+            first_ = false;
+        } else if (cutoff == last_cutoff_ && resonance == last_resonance_) {
+            return;
+        } else {
+            const float cutoff_smooth = 1.2f;  // Same as liquidsfz for order 2
+            const float reso_smooth = 1.0f;
+
+            const float high = cutoff_smooth;
+            const float low = 1.0f / high;
+
+            cutoff = std::clamp(cutoff, last_cutoff_ * low, last_cutoff_ * high);
+            resonance = std::clamp(resonance, last_resonance_ - reso_smooth, last_resonance_ + reso_smooth);
+        }
+
+        last_cutoff_ = cutoff;
+        last_resonance_ = resonance;
+
+        float c[5];
+        Filter::design(type_, Filter::prewarp(cutoff, sample_rate_), Filter::fast_db_to_factor(resonance),
+                       c[0], c[1], c[2], c[3], c[4]);
+        b0_ = fixed_from_float<int32_t>(c[0], coefbits);
+        b1_ = fixed_from_float<int32_t>(c[1], coefbits);
+        b2_ = fixed_from_float<int32_t>(c[2], coefbits);
+        a1_ = fixed_from_float<int32_t>(c[3], coefbits);
+        a2_ = fixed_from_float<int32_t>(c[4], coefbits);
+    }
+
+    bool enabled_ = false;
+    Filter::Type type_ = Filter::NONE;
+    float sample_rate_ = 0.0f;
+    float cutoff_ = 1000.0f;
+    float resonance_ = 0.0f;  // In dB (same as liquidsfz)
+
+    // Parameter smoothing state
+    bool first_ = true;
+    int countdown_ = 0;
+    float last_cutoff_ = 10.0f;
+    float last_resonance_ = 0.0f;
+
+    // Biquad coefficients, Q2.29
+    int32_t b0_ = 1 << coefbits, b1_ = 0, b2_ = 0;
+    int32_t a1_ = 0, a2_ = 0;
+
+    // Delay line and the fractional part of the last output, Q2.29
+    sample_t x1_ = 0, x2_ = 0;
+    sample_t y1_ = 0, y2_ = 0;
+    int64_t error_ = 0;
+};
+
+#endif // MK_FREEVERB_FILTER_FIXED_HPP
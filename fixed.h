@@ -0,0 +1,109 @@
+// Fixed-point helpers for the Q15/Q31 reverb
+//
+// Samples are int16_t (Q15) or int32_t (Q31), i.e. values in [-1, 1).
+// Products of two samples fit fixed_format<sample_t>::wide_t. Every result
+// written back to a sample is rounded to nearest and saturated, so overload
+// clips instead of wrapping around. Floats are only used to convert
+// coefficients when parameters change.
+
+#ifndef _fixed_
+#define _fixed_
+
+#include <cstdint>
+#include <limits>
+
+#if defined(__ARM_FEATURE_DSP)
+#include <arm_acle.h>
+#endif
+
+template <typename sample_t> struct fixed_format;
+
+template <> struct fixed_format<int16_t>
+{
+	typedef int32_t	wide_t;
+	enum { fracbits = 15 };
+};
+
+template <> struct fixed_format<int32_t>
+{
+	typedef int64_t	wide_t;
+	enum { fracbits = 31 };
+};
+
+template <typename sample_t, typename wide_t>
+inline sample_t fixed_saturate(wide_t v)
+{
+	const wide_t hi = std::numeric_limits<sample_t>::max();
+	const wide_t lo = std::numeric_limits<sample_t>::min();
+	return static_cast<sample_t>(v > hi ? hi : (v < lo ? lo : v));
+}
+
+// v / 2^shift, rounded to nearest
+template <typename wide_t>
+inline wide_t fixed_round_shift(wide_t v, int shift)
+{
+	return (v + (static_cast<wide_t>(1) << (shift-1))) >> shift;
+}
+
+template <typename sample_t>
+inline sample_t fixed_add(sample_t a, sample_t b)
+{
+	typedef typename fixed_format<sample_t>::wide_t wide_t;
+	return fixed_saturate<sample_t>(static_cast<wide_t>(a) + b);
+}
+
+template <typename sample_t>
+inline sample_t fixed_sub(sample_t a, sample_t b)
+{
+	typedef typename fixed_format<sample_t>::wide_t wide_t;
+	return fixed_saturate<sample_t>(static_cast<wide_t>(a) - b);
+}
+
+#if defined(__ARM_FEATURE_DSP)
+template <> inline int32_t fixed_add<int32_t>(int32_t a, int32_t b) { return __qadd(a, b); }
+template <> inline int32_t fixed_sub<int32_t>(int32_t a, int32_t b) { return __qsub(a, b); }
+#endif
+
+// a * c, where c has coefbits fractional bits
+template <typename sample_t>
+inline sample_t fixed_mul(sample_t a, sample_t c, int coefbits)
+{
+	typedef typename fixed_format<sample_t>::wide_t wide_t;
+	return fixed_saturate<sample_t>(fixed_round_shift(static_cast<wide_t>(a) * c, coefbits));
+}
+
+// a * ca + b * cb with a single rounding
+template <typename sample_t>
+inline sample_t fixed_mac2(sample_t a, sample_t ca, sample_t b, sample_t cb, int coefbits)
+{
+	typedef typename fixed_format<sample_t>::wide_t wide_t;
+	return fixed_saturate<sample_t>(fixed_round_shift(static_cast<wide_t>(a) * ca + static_cast<wide_t>(b) * cb, coefbits));
+}
+
+// Coefficient with fracbits fractional bits, rounded and saturated to int_t
+template <typename int_t>
+inline int_t fixed_from_float(float v, int fracbits)
+{
+	double scaled = static_cast<double>(v) * static_cast<double>(static_cast<int64_t>(1) << fracbits);
+	scaled += scaled < 0 ? -0.5 : 0.5;
+	const double hi = static_cast<double>(std::numeric_limits<int_t>::max());
+	const double lo = static_cast<double>(std::numeric_limits<int_t>::min());
+	return static_cast<int_t>(scaled > hi ? hi : (scaled < lo ? lo : scaled));
+}
+
+// Conversions between float [-1, 1) and samples
+template <typename sample_t>
+inline sample_t fixed_sample(float v)
+{
+	return fixed_from_float<sample_t>(v, fixed_format<sample_t>::fracbits);
+}
+
+template <typename sample_t>
+inline float fixed_to_float(sample_t v)
+{
+	return static_cast<float>(static_cast<double>(v) / static_cast<double>(static_cast<int64_t>(1) << fixed_format<sample_t>::fracbits));
+}
+
+#endif//_fixed_
+
+//ends
@@ -1,37 +1,96 @@
 #include "mk_freeverb.hpp"
+#include "mk_freeverb_pipeline.hpp"
+#include <algorithm>
+#include <array>
+#include <climits>
+#include <cmath>
+#include <cstring>
 
-mk_freeverb::mk_freeverb(float sr)
-    : sampleRate(sr)
-{
-    // Initialize comb filters (only the ones we're using)
-    combL[0].setbuffer(bufcombL1, combtuningL1);
-    combR[0].setbuffer(bufcombR1, combtuningR1);
-    combL[1].setbuffer(bufcombL2, combtuningL2);
-    combR[1].setbuffer(bufcombR2, combtuningR2);
-    combL[2].setbuffer(bufcombL3, combtuningL3);
-    combR[2].setbuffer(bufcombR3, combtuningR3);
-    combL[3].setbuffer(bufcombL4, combtuningL4);
-    combR[3].setbuffer(bufcombR4, combtuningR4);
-
-#if MK_FREEVERB_NUM_COMBS > 4
-    combL[4].setbuffer(bufcombL5, combtuningL5);
-    combR[4].setbuffer(bufcombR5, combtuningR5);
-    combL[5].setbuffer(bufcombL6, combtuningL6);
-    combR[5].setbuffer(bufcombR6, combtuningR6);
-    combL[6].setbuffer(bufcombL7, combtuningL7);
-    combR[6].setbuffer(bufcombR7, combtuningR7);
-    combL[7].setbuffer(bufcombL8, combtuningL8);
-    combR[7].setbuffer(bufcombR8, combtuningR8);
-#endif
-
-    allpassL[0].setbuffer(bufallpassL1, allpasstuningL1);
-    allpassR[0].setbuffer(bufallpassR1, allpasstuningR1);
-    allpassL[1].setbuffer(bufallpassL2, allpasstuningL2);
-    allpassR[1].setbuffer(bufallpassR2, allpasstuningR2);
-    allpassL[2].setbuffer(bufallpassL3, allpasstuningL3);
-    allpassR[2].setbuffer(bufallpassR3, allpasstuningR3);
-    allpassL[3].setbuffer(bufallpassL4, allpasstuningL4);
-    allpassR[3].setbuffer(bufallpassR4, allpasstuningR4);
+namespace {
+
+// Bytes per delay line, rounded up so the next line starts on an arena alignment boundary.
+// Comb and allpass lines hold delay_sample, predelay lines float.
+size_t line_bytes(size_t samples, size_t sampleBytes = sizeof(delay_sample))
+{
+    const size_t align = MK_FREEVERB_ARENA_ALIGN;
+    return (samples * sampleBytes + align - 1) / align * align;
+}
+
+// Copies n samples into a ring of ringSize (a power of two) starting at
+// pos, and back out, split in two at the wrap point
+void ring_write(float *ring, size_t ringSize, size_t pos, const float *src, size_t n)
+{
+    const size_t first = n < ringSize - pos ? n : ringSize - pos;
+    std::memcpy(ring + pos, src, first * sizeof(float));
+    std::memcpy(ring, src + first, (n - first) * sizeof(float));
+}
+
+void ring_read(const float *ring, size_t ringSize, size_t pos, float *dst, size_t n)
+{
+    const size_t first = n < ringSize - pos ? n : ringSize - pos;
+    std::memcpy(dst, ring + pos, first * sizeof(float));
+    std::memcpy(dst + first, ring, (n - first) * sizeof(float));
+}
+
+// Samples over which short predelay moves glide
+const int predelay_glide = 256;
+
+// Reads sample i of a block written at pos, delay samples back, with
+// linear interpolation between the two neighbouring ring positions
+inline float ring_tap(const float *ring, size_t mask, size_t pos, int i, float delay)
+{
+    const size_t whole = static_cast<size_t>(delay);
+    const float frac = delay - static_cast<float>(whole);
+    const size_t at = pos + static_cast<size_t>(i) - whole;
+    return ring[at & mask] + (ring[(at - 1) & mask] - ring[at & mask]) * frac;
+}
+
+template <int numcombs_, bool predelay>
+size_t arena_used_bytes(float maxSampleRate)
+{
+    size_t bytes = 0;
+    for (int i = 0; i < numcombs_; i++)
+        bytes += line_bytes(scaledtuning(combtuningsL[i], maxSampleRate))
+               + line_bytes(scaledtuning(combtuningsR[i], maxSampleRate));
+    for (int i = 0; i < numallpasses; i++)
+        bytes += line_bytes(scaledtuning(allpasstuningsL[i], maxSampleRate))
+               + line_bytes(scaledtuning(allpasstuningsR[i], maxSampleRate));
+    if (predelay)
+        bytes += 2 * line_bytes(mk_freeverb::predelayRingSize, sizeof(float));
+    return bytes;
+}
+
+}
+
+template <int numcombs_, unsigned features_>
+size_t basic_mk_freeverb<numcombs_, features_>::arena_bytes(float maxSampleRate)
+{
+    // Slack so any caller buffer can be aligned up internally
+    return arena_used_bytes<numcombs_, predelayEnabled>(maxSampleRate) + MK_FREEVERB_ARENA_ALIGN - 1;
+}
+
+template <int numcombs_, unsigned features_>
+basic_mk_freeverb<numcombs_, features_>::basic_mk_freeverb(float sr, float maxsr)
+    : basic_mk_freeverb(sr, nullptr, 0, maxsr)
+{
+}
+
+template <int numcombs_, unsigned features_>
+basic_mk_freeverb<numcombs_, features_>::basic_mk_freeverb(float sr, void *arenaMemory, size_t arenaSize, float maxsr)
+    : sampleRate(sr), maxSampleRate(maxsr < sr ? sr : maxsr)
+{
+    if (arenaMemory == nullptr || arenaSize < arena_bytes(maxSampleRate))
+    {
+        arenaMemory = ::operator new(arena_bytes(maxSampleRate));
+        ownedArena = arenaMemory;
+    }
+
+    uintptr_t base = reinterpret_cast<uintptr_t>(arenaMemory);
+    base = (base + MK_FREEVERB_ARENA_ALIGN - 1) & ~static_cast<uintptr_t>(MK_FREEVERB_ARENA_ALIGN - 1);
+    arena = reinterpret_cast<char *>(base);
+    std::memset(arena, 0, arena_used_bytes<numcombs_, predelayEnabled>(maxSampleRate));
+
+    layout();
 
     allpassL[0].setfeedback(0.5f);
     allpassR[0].setfeedback(0.5f);
@@ -52,302 +111,1048 @@ mk_freeverb::mk_freeverb(float sr)
     width = 1.0f;
     mode = 0.0f;
 
-    // Mark that we need to apply default preset on first use
-    presetPending = true;
-    pendingPreset = ReverbPresets::DEFAULT_PRESET;
+    // Queue the default preset so it is applied on first use
+    queue_preset(ReverbPresets::DEFAULT_PRESET);
 
-#if MK_FREEVERB_ENABLE_INPUT_FILTER
-    input_filter = std::make_shared<Filter>(Filter::Type::Lowpass, sampleRate);
-    input_filter->setCutoff(8000.f);
-    input_filter->setResonance(0.5f);
-#endif
+    if constexpr (inputFilterEnabled)
+    {
+        inputFilter.reset(Filter::Type::Lowpass, sampleRate);
+        inputFilter.setCutoff(8000.f);
+        inputFilter.setResonance(0.5f);
+    }
 
 
     update(); // Safe to call - just updates coefficients, no filter operations
 
-#if MK_FREEVERB_ENABLE_PREDELAY
-    // Initialize predelay buffers to zero
-    for (size_t i = 0; i < MK_FREEVERB_MAX_PREDELAY_SAMPLES; i++) {
-        predelayBufferL[i] = 0.0f;
-        predelayBufferR[i] = 0.0f;
-#if MK_FREEVERB_ENABLE_PREDELAY_CROSSFADE
-        predelayBufferL_new[i] = 0.0f;
-        predelayBufferR_new[i] = 0.0f;
-#endif
+    mute();
+}
+
+template <int numcombs_, unsigned features_>
+basic_mk_freeverb<numcombs_, features_>::~basic_mk_freeverb()
+{
+    ::operator delete(ownedArena);
+}
+
+template <int numcombs_, unsigned features_>
+void basic_mk_freeverb<numcombs_, features_>::layout()
+{
+    // Lines are spaced for maxSampleRate, lengths follow the current rate
+    const float rate = sampleRate < maxSampleRate ? sampleRate : maxSampleRate;
+
+    // Carve every delay line from the arena (only the combs we're using)
+    char *line = arena;
+    for (int i = 0; i < numcombs_; i++)
+    {
+        delay_sample *bufL = reinterpret_cast<delay_sample *>(line);
+        line += line_bytes(scaledtuning(combtuningsL[i], maxSampleRate));
+        delay_sample *bufR = reinterpret_cast<delay_sample *>(line);
+        line += line_bytes(scaledtuning(combtuningsR[i], maxSampleRate));
+        setcombbuffers(i, bufL, scaledtuning(combtuningsL[i], rate),
+                       bufR, scaledtuning(combtuningsR[i], rate));
+    }
+
+    for (int i = 0; i < numallpasses; i++)
+    {
+        allpassL[i].setbuffer(reinterpret_cast<delay_sample *>(line), scaledtuning(allpasstuningsL[i], rate));
+        line += line_bytes(scaledtuning(allpasstuningsL[i], maxSampleRate));
+        allpassR[i].setbuffer(reinterpret_cast<delay_sample *>(line), scaledtuning(allpasstuningsR[i], rate));
+        line += line_bytes(scaledtuning(allpasstuningsR[i], maxSampleRate));
+    }
+
+    if constexpr (predelayEnabled)
+    {
+        predelayBufferL = reinterpret_cast<float *>(line);
+        line += line_bytes(predelayRingSize, sizeof(float));
+        predelayBufferR = reinterpret_cast<float *>(line);
+        line += line_bytes(predelayRingSize, sizeof(float));
+    }
+}
+
+template <int numcombs_, unsigned features_>
+void basic_mk_freeverb<numcombs_, features_>::set_sample_rate(float sr)
+{
+    float predelaySeconds = getPredelay();
+    sampleRate = sr;
+
+    // Old contents do not fit the new lengths - start from silence
+    std::memset(arena, 0, arena_used_bytes<numcombs_, predelayEnabled>(maxSampleRate));
+    layout();
+
+    // The comb damping filters still hold the end of the old tail
+#if MK_FREEVERB_ENABLE_COMB_BANK
+    combs.mute();
+#else
+    for (int i = 0; i < numcombs_; i++)
+    {
+        combL[i].mute();
+        combR[i].mute();
     }
-    predelaySize = 0;
-    predelayWrite = 0;
-    predelayRead = 0;
-#if MK_FREEVERB_ENABLE_PREDELAY_CROSSFADE
-    predelaySize_new = 0;
-    predelayWrite_new = 0;
-    predelayRead_new = 0;
-    fadeSamples = 0;
-    fadeCount = 0;
 #endif
+#if MK_FREEVERB_ENABLE_SLEEP
+    update_sleep_hold();
 #endif
 
-    mute();
+    if constexpr (inputFilterEnabled)
+        inputFilter.reset(inputFilter.getType(), sr);
+    if constexpr (predelayEnabled)
+    {
+        // The rings are silent, so the tap can move without a glide or fade
+        setPredelay(predelaySeconds);
+        predelayDelay = predelayTarget;
+        fadeCount = 0;
+        glideCount = 0;
+        predelayMonoOnly = false;
+        predelayMonoRun = predelayRingSize;
+    }
 }
 
-void mk_freeverb::initialize()
+template <int numcombs_, unsigned features_>
+void basic_mk_freeverb<numcombs_, features_>::setcombbuffers(int index, delay_sample *bufL, int sizeL, delay_sample *bufR, int sizeR)
+{
+    if (index >= numcombs_) return;
+
+#if MK_FREEVERB_ENABLE_COMB_BANK
+    combs.setbuffer(index, bufL, sizeL);
+    combs.setbuffer(numcombs_ + index, bufR, sizeR);
+#else
+    combL[index].setbuffer(bufL, sizeL);
+    combR[index].setbuffer(bufR, sizeR);
+#endif
+}
+
+template <int numcombs_, unsigned features_>
+void basic_mk_freeverb<numcombs_, features_>::initialize()
 {
     // Safe to apply preset now that construction is complete
     apply_preset(ReverbPresets::DEFAULT_PRESET);
 }
 
-void mk_freeverb::mute()
+template <int numcombs_, unsigned features_>
+void basic_mk_freeverb<numcombs_, features_>::mute()
 {
     if (getMode() >= freezemode) return;
 
-    for (int i = 0; i < MK_FREEVERB_NUM_COMBS; i++)
+#if MK_FREEVERB_ENABLE_COMB_BANK
+    combs.mute();
+#else
+    for (int i = 0; i < numcombs_; i++)
     {
         combL[i].mute();
         combR[i].mute();
     }
+#endif
     for (int i = 0; i < numallpasses; i++)
     {
         allpassL[i].mute();
         allpassR[i].mute();
     }
+
+    // The rest of the signal path goes back to the state of a new instance,
+    // so nothing held before a mute (or sleep) plays after it
+    if constexpr (inputFilterEnabled)
+        inputFilter.mute();
+    if constexpr (predelayEnabled)
+    {
+        std::memset(predelayBufferL, 0, predelayRingSize * sizeof(float));
+        std::memset(predelayBufferR, 0, predelayRingSize * sizeof(float));
+        predelayMonoRun = predelayRingSize;
+        predelayMonoOnly = false;
+
+        // Pending glides and fades would only move between silent taps
+        predelayDelay = predelayTarget;
+        predelayIncoming = predelayTarget;
+        glideCount = 0;
+        fadeCount = 0;
+    }
 }
 
-void mk_freeverb::processreplace(float *inputL, float *inputR, float *outputL, float *outputR, long numsamples, int skip)
+template <int numcombs_, unsigned features_>
+void basic_mk_freeverb<numcombs_, features_>::processreplace(float *inputL, float *inputR, float *outputL, float *outputR, long numsamples, int skip)
 {
-    if (presetPending)
+    run(inputL, inputR, outputL, outputR, numsamples, skip);
+}
+
+template <int numcombs_, unsigned features_>
+void basic_mk_freeverb<numcombs_, features_>::process_block(const float *inputL, const float *inputR, float *outputL, float *outputR, int numsamples)
+{
+    run(inputL, inputR, outputL, outputR, numsamples, 1);
+}
+
+template <int numcombs_, unsigned features_>
+void basic_mk_freeverb<numcombs_, features_>::processmix(float *inputL, float *inputR, float *outputL, float *outputR, long numsamples, int skip,
+                                                         float mixGain)
+{
+    run(inputL, inputR, outputL, outputR, numsamples, skip, nullptr, true, mixGain);
+}
+
+template <int numcombs_, unsigned features_>
+void basic_mk_freeverb<numcombs_, features_>::process_block_mix(const float *inputL, const float *inputR, float *outputL, float *outputR,
+                                                                int numsamples, float mixGain)
+{
+    run(inputL, inputR, outputL, outputR, numsamples, 1, nullptr, true, mixGain);
+}
+
+template <int numcombs_, unsigned features_>
+void basic_mk_freeverb<numcombs_, features_>::process_mono_in(const float *input, float *outputL, float *outputR, int numsamples)
+{
+    run(input, input, outputL, outputR, numsamples, 1);
+}
+
+template <int numcombs_, unsigned features_>
+void basic_mk_freeverb<numcombs_, features_>::process_sends(const ReverbSend *sends, int numSends, float *outputL, float *outputR,
+                                                            int numsamples)
+{
+    sendList = sends;
+    sendCount = numSends;
+    run(nullptr, nullptr, outputL, outputR, numsamples, 1);
+    sendList = nullptr;
+    sendCount = 0;
+}
+
+template <int numcombs_, unsigned features_>
+void basic_mk_freeverb<numcombs_, features_>::process_pipelined(mk_freeverb_pipeline &pipeline, const float *inputL, const float *inputR,
+                                                                float *outputL, float *outputR, long numsamples, int skip)
+{
+    run(inputL, inputR, outputL, outputR, numsamples, skip, &pipeline);
+}
+
+template <int numcombs_, unsigned features_>
+void basic_mk_freeverb<numcombs_, features_>::run(const float *inputL, const float *inputR, float *outputL, float *outputR, long numsamples, int skip,
+                                                  mk_freeverb_pipeline *pipeline, bool accumulate, float gain)
+{
+    mixAccumulate = accumulate;
+    mixGain = gain;
+
+#if MK_FREEVERB_DENORMAL_MODE == MK_FREEVERB_DENORMALS_FTZ
+    // Flush denormals in hardware for the whole call instead of testing every sample
+    denormal_guard ftz;
+#endif
+
+    // Bounded drain: anything beyond this stays queued for the next call.
+    // Batches come out whole, so a preset is never applied in two parts
+    int numEvents = events.pop(blockEvents, MK_FREEVERB_MAX_EVENTS_PER_BLOCK);
+    int next = apply_events(0, numEvents, 0);
+
+    long pos = 0;
+    while (pos < numsamples)
     {
-        apply_preset_internal(pendingPreset);
-        presetPending = false;
+        // Render up to the next event offset, then apply everything due there
+        long end = numsamples;
+        if (next < numEvents && blockEvents[next].offset < end)
+            end = blockEvents[next].offset;
+
+        while (pos < end)
+        {
+            if (pipeline && steady())
+            {
+                // Nothing changes before the next event: spread the span over the pipeline
+                pos = pipeline_span(*pipeline, inputL, inputR, outputL, outputR, pos, end, skip);
+#if MK_FREEVERB_ENABLE_SMOOTHING
+                primed = true;
+#endif
+                continue;
+            }
+
+            int n = end - pos < MK_FREEVERB_BLOCK_SIZE ? static_cast<int>(end - pos) : MK_FREEVERB_BLOCK_SIZE;
+#if MK_FREEVERB_ENABLE_SMOOTHING
+            // While ramping, chunks end on control-rate boundaries
+            bool smoothing = ramping();
+            if (smoothing && n > controlCountdown) n = controlCountdown;
+#endif
+            if (sendList)
+            {
+                // All sources summed into one input block first (skip is 1)
+                const bool stereo = sum_sends(pos, n);
+                process_chunk(sendL, stereo ? sendR : sendL, outputL + pos, outputR + pos, n, 1);
+            }
+            else
+            {
+                process_chunk(inputL + pos * skip, inputR + pos * skip, outputL + pos * skip, outputR + pos * skip, n, skip);
+            }
+            pos += n;
+#if MK_FREEVERB_ENABLE_SMOOTHING
+            primed = true;
+            if (smoothing && (controlCountdown -= n) == 0)
+            {
+                controlCountdown = MK_FREEVERB_CONTROL_RATE;
+                control_tick();
+            }
+#endif
+        }
+
+        next = apply_events(next, numEvents, pos);
     }
 
-#if MK_FREEVERB_ENABLE_INPUT_FILTER
-    // Initialize input filter on first use when sample rate is guaranteed to be valid
-    static bool filter_initialized = false;
-    if (!filter_initialized && sampleRate > 0.0f)
+    // Offsets past the end of this call
+    apply_events(next, numEvents, LONG_MAX);
+}
+
+template <int numcombs_, unsigned features_>
+int basic_mk_freeverb<numcombs_, features_>::apply_events(int first, int count, long position)
+{
+    // Consecutive events due at the same position share one coefficient update
+    bool combsChanged = false;
+    bool wetChanged = false;
+    int i = first;
+    for (; i < count && blockEvents[i].offset <= position; i++)
     {
-        if (input_filter) {
-            input_filter->reset(Filter::Type::Lowpass, sampleRate);
-            input_filter->setCutoff(8000.f);
-            input_filter->setResonance(0.5f);
+        const ReverbParamEvent &event = blockEvents[i];
+        switch (event.param)
+        {
+        case ReverbParamEvent::RoomSize:  roomSize = event.value; combsChanged = true; break;
+        case ReverbParamEvent::Damp:      damp = event.value; combsChanged = true; break;
+        case ReverbParamEvent::Wet:       wet = event.value; wetChanged = true; break;
+        case ReverbParamEvent::Dry:       dry = event.value; break;
+        case ReverbParamEvent::Width:     width = event.value; wetChanged = true; break;
+        case ReverbParamEvent::Mode:      mode = event.value; combsChanged = true; break;
+        case ReverbParamEvent::Predelay:  setPredelay(event.value); break;
+        case ReverbParamEvent::Cutoff:    setLPCutoff(event.value); break;
+        case ReverbParamEvent::Resonance: if constexpr (inputFilterEnabled) inputFilter.setResonance(event.value); break;
+        case ReverbParamEvent::Preset:
+        {
+            int index = static_cast<int>(event.value);
+            if (index >= 0 && index < ReverbPresets::NUM_PRESETS)
+                apply_preset_internal(*ReverbPresets::ALL_PRESETS[index]);
+            break;
+        }
+        default:
+            break;
         }
-        filter_initialized = true;
     }
-#endif
 
-    while (numsamples-- > 0)
+    if (combsChanged) update_combs();
+    if (wetChanged) update_wet();
+    if (i > first) processStats.add_events(i - first);
+    return i;
+}
+
+#if MK_FREEVERB_ENABLE_SLEEP
+namespace {
+
+float block_peak(const float *buffer, int numsamples, int skip)
+{
+    float peak = 0.0f;
+    for (int i = 0; i < numsamples; i++)
     {
-        float inL = *inputL;
-        float inR = *inputR;
+        float level = std::fabs(buffer[i * skip]);
+        peak = level > peak ? level : peak;
+    }
+    return peak;
+}
 
-#if MK_FREEVERB_ENABLE_INPUT_FILTER
-        // Apply input filtering if enabled
-        if (input_filter) {
-            inL = input_filter->process(inL);
-            inR = input_filter->process(inR);
-        }
+bool block_quiet(const float *buffer, int numsamples)
+{
+    return block_peak(buffer, numsamples, 1) <= MK_FREEVERB_SLEEP_THRESHOLD;
+}
+
+}
 #endif
 
-        float predelayedL = inL;
-        float predelayedR = inR;
+namespace {
 
-#if MK_FREEVERB_ENABLE_PREDELAY
-        // Predelay processing
-        if (predelaySize > 0)
+// dstL/R[i] = sum of gain * input over the sends, in one pass: each
+// vector of output reads every source once and is stored once. Mono
+// sends (right null) feed both channels; with stereo false only dstL is
+// written. Sends are added in order, in vectors and in the scalar tail
+template <bool stereo>
+void sum_sends_block(const ReverbSend *sends, int count, long pos, float *dstL, float *dstR, int n)
+{
+    int i = 0;
+    for (; i + MK_FREEVERB_SIMD_WIDTH <= n; i += MK_FREEVERB_SIMD_WIDTH)
+    {
+        simd_float l = simd_mul(simd_loadu(sends[0].left + pos + i), simd_set1(sends[0].gain));
+        simd_float r = l;
+        if constexpr (stereo)
         {
-#if MK_FREEVERB_ENABLE_PREDELAY_CROSSFADE
-            // Complex crossfade version (not RT-safe due to dynamic allocation)
-            if (fadeCount > 0)
-            {
-                predelayBufferL[predelayWrite] = inL;
-                predelayBufferR[predelayWrite] = inR;
+            if (sends[0].right)
+                r = simd_mul(simd_loadu(sends[0].right + pos + i), simd_set1(sends[0].gain));
+        }
+        for (int k = 1; k < count; k++)
+        {
+            const simd_float g = simd_set1(sends[k].gain);
+            const simd_float x = simd_mul(simd_loadu(sends[k].left + pos + i), g);
+            l = simd_add(l, x);
+            if constexpr (stereo)
+                r = simd_add(r, sends[k].right ? simd_mul(simd_loadu(sends[k].right + pos + i), g) : x);
+        }
+        simd_storeu(dstL + i, l);
+        if constexpr (stereo)
+            simd_storeu(dstR + i, r);
+    }
+    for (; i < n; i++)
+    {
+        float l = sends[0].left[pos + i] * sends[0].gain;
+        float r = l;
+        if constexpr (stereo)
+        {
+            if (sends[0].right)
+                r = sends[0].right[pos + i] * sends[0].gain;
+        }
+        for (int k = 1; k < count; k++)
+        {
+            const float x = sends[k].left[pos + i] * sends[k].gain;
+            l += x;
+            if constexpr (stereo)
+                r += sends[k].right ? sends[k].right[pos + i] * sends[k].gain : x;
+        }
+        dstL[i] = l;
+        if constexpr (stereo)
+            dstR[i] = r;
+    }
+}
 
-                predelayBufferL_new[predelayWrite_new] = inL;
-                predelayBufferR_new[predelayWrite_new] = inR;
+}
 
-                float oldL = predelayBufferL[predelayRead];
-                float oldR = predelayBufferR[predelayRead];
+template <int numcombs_, unsigned features_>
+bool basic_mk_freeverb<numcombs_, features_>::sum_sends(long pos, int numsamples)
+{
+    if (sendCount <= 0)
+    {
+        std::memset(sendL, 0, numsamples * sizeof(float));
+        return false;
+    }
 
-                float newL = predelayBufferL_new[predelayRead_new];
-                float newR = predelayBufferR_new[predelayRead_new];
+    // Only mono sends: a mono sum, which takes the mono input path
+    bool stereo = false;
+    for (int k = 0; k < sendCount; k++)
+        stereo = stereo || (sendList[k].right && sendList[k].right != sendList[k].left);
 
-                float fade = static_cast<float>(fadeCount) / fadeSamples;
-                predelayedL = oldL * fade + newL * (1.0f - fade);
-                predelayedR = oldR * fade + newR * (1.0f - fade);
+    if (stereo)
+        sum_sends_block<true>(sendList, sendCount, pos, sendL, sendR, numsamples);
+    else
+        sum_sends_block<false>(sendList, sendCount, pos, sendL, sendR, numsamples);
+    return stereo;
+}
 
-                predelayWrite = (predelayWrite + 1) % predelaySize;
-                predelayRead = (predelayRead + 1) % predelaySize;
-                predelayWrite_new = (predelayWrite_new + 1) % predelaySize_new;
-                predelayRead_new = (predelayRead_new + 1) % predelaySize_new;
+template <int numcombs_, unsigned features_>
+void basic_mk_freeverb<numcombs_, features_>::process_chunk(const float *inputL, const float *inputR, float *outputL, float *outputR, int numsamples, int skip)
+{
+    mk_freeverb_stats::block_timer timer;
 
-                fadeCount--;
-                if (fadeCount == 0)
+    // Both inputs reading the same buffer is a mono source
+    const bool mono = inputL == inputR;
+
+#if MK_FREEVERB_ENABLE_SLEEP
+    if (sleeping)
+    {
+        // Stay asleep while the input is silent: no DSP, wet output is zero
+        // and adds nothing to an accumulated output
+        if (block_peak(inputL, numsamples, skip) <= MK_FREEVERB_SLEEP_THRESHOLD &&
+            (mono || block_peak(inputR, numsamples, skip) <= MK_FREEVERB_SLEEP_THRESHOLD))
+        {
+            if (!mixAccumulate || dry != 0.0f)
+            {
+                for (int i = 0; i < numsamples; i++)
                 {
-                    // Swap the buffers (RT-safe with static arrays)
-                    for (size_t i = 0; i < predelaySize_new; i++) {
-                        predelayBufferL[i] = predelayBufferL_new[i];
-                        predelayBufferR[i] = predelayBufferR_new[i];
-                    }
-                    predelaySize = predelaySize_new;
-                    predelayWrite = predelayWrite_new;
-                    predelayRead = predelayRead_new;
+                    blockOutL[i] = 0.0f;
+                    blockOutR[i] = 0.0f;
                 }
+                mix_stage(blockOutL, blockOutR, inputL, inputR, outputL, outputR, numsamples, skip);
             }
-            else
-            {
-                // Normal predelay operation
-                predelayBufferL[predelayWrite] = inL;
-                predelayBufferR[predelayWrite] = inR;
+            timer.lap(ReverbStage::Mix);
+            processStats.add_block(timer, numsamples);
+            return;
+        }
 
-                predelayedL = predelayBufferL[predelayRead];
-                predelayedR = predelayBufferR[predelayRead];
+        // State was cleared on the way to sleep, so this resumes exactly
+        // like a reverb that kept running on a decayed tail
+        sleeping = false;
+        quietSamples = 0;
+    }
+#endif
 
-                predelayWrite = (predelayWrite + 1) % predelaySize;
-                predelayRead = (predelayRead + 1) % predelaySize;
-            }
+    bool leftOnly = input_stage(inputL, inputR, numsamples, skip, mono);
+    timer.lap(ReverbStage::Input);
+#if MK_FREEVERB_ENABLE_SLEEP
+    // Input going into the predelay ring is not silence either, even while
+    // the tap still reads older samples
+    bool inputQuiet = block_quiet(blockL, numsamples) && (leftOnly || block_quiet(blockR, numsamples));
+#endif
+    if constexpr (predelayEnabled)
+    {
+        leftOnly = predelay_stage(numsamples, leftOnly);
+        timer.lap(ReverbStage::Predelay);
+#if MK_FREEVERB_ENABLE_SLEEP
+        inputQuiet = inputQuiet && block_quiet(blockL, numsamples) && (leftOnly || block_quiet(blockR, numsamples));
+#endif
+    }
+    comb_stage(numsamples, leftOnly);
+#if MK_FREEVERB_ENABLE_SLEEP
+    // blockL/R hold the comb input (after predelay, blockL alone when
+    // leftOnly), blockOutL/R the comb output
+    track_tail(inputQuiet && block_quiet(blockOutL, numsamples) && block_quiet(blockOutR, numsamples), numsamples);
+#endif
+    timer.lap(ReverbStage::Combs);
+    allpass_stage(numsamples);
+    timer.lap(ReverbStage::Allpasses);
+    mix_stage(blockOutL, blockOutR, inputL, inputR, outputL, outputR, numsamples, skip);
+
+#if MK_FREEVERB_ENABLE_SLEEP
+    if (quietSamples >= sleepHold)
+    {
+        mute();
+        sleeping = true;
+    }
+#endif
+    timer.lap(ReverbStage::Mix);
+    processStats.add_block(timer, numsamples);
+}
+
+#if MK_FREEVERB_ENABLE_SLEEP
+template <int numcombs_, unsigned features_>
+void basic_mk_freeverb<numcombs_, features_>::track_tail(bool quiet, int numsamples)
+{
+    if (quiet)
+    {
+        quietSamples += numsamples;
+    }
+    else
+    {
+        quietSamples = 0;
+    }
+}
+
+template <int numcombs_, unsigned features_>
+void basic_mk_freeverb<numcombs_, features_>::update_sleep_hold()
+{
+    // Freeze (or any feedback >= 1) never decays, so never sleep
+    if (roomSize1 >= 1.0f)
+    {
+        sleepHold = LONG_MAX;
+        return;
+    }
+
+    // The comb output must stay quiet for enough round trips of the longest
+    // comb for what is left in the loop to fall another 40 dB
+    const float rate = sampleRate < maxSampleRate ? sampleRate : maxSampleRate;
+    long longest = 0;
+    for (int i = 0; i < numcombs_; i++)
+    {
+        long length = scaledtuning(combtuningsR[i], rate);
+        longest = length > longest ? length : longest;
+    }
+
+    long trips = 1;
+    if (roomSize1 > 0.0f)
+    {
+        trips = static_cast<long>(std::ceil(std::log(0.01f) / std::log(roomSize1)));
+        trips = trips < 1 ? 1 : trips;
+    }
+    sleepHold = trips * longest;
+
+    // Input still in the predelay ring has not reached the combs, so the
+    // hold also covers the longest tap in use (either side of a crossfade);
+    // the last loud input then gets to the combs before the hold runs out
+    if constexpr (predelayEnabled)
+    {
+        const float tap = std::max(predelayTarget, std::max(predelayDelay, predelayIncoming));
+        sleepHold += static_cast<long>(std::ceil(tap)) + 1;
+    }
+}
+#endif
+
+template <int numcombs_, unsigned features_>
+bool basic_mk_freeverb<numcombs_, features_>::is_sleeping() const
+{
+#if MK_FREEVERB_ENABLE_SLEEP
+    return sleeping;
 #else
-            // Simple predelay (RT-safe, no crossfading)
-            predelayBufferL[predelayWrite] = inL;
-            predelayBufferR[predelayWrite] = inR;
+    return false;
+#endif
+}
 
-            predelayedL = predelayBufferL[predelayRead];
-            predelayedR = predelayBufferR[predelayRead];
+template <int numcombs_, unsigned features_>
+bool basic_mk_freeverb<numcombs_, features_>::input_stage(const float *inputL, const float *inputR, int numsamples, int skip, bool mono)
+{
+    // A mono source only fills blockL, unless the filter's right channel
+    // still holds stereo history
+    bool leftOnly = mono;
+    if constexpr (inputFilterEnabled)
+        leftOnly = leftOnly && inputFilter.channels_match();
 
-            predelayWrite = (predelayWrite + 1) % predelaySize;
-            predelayRead = (predelayRead + 1) % predelaySize;
+    if (leftOnly)
+    {
+        for (int i = 0; i < numsamples; i++)
+        {
+#if MK_FREEVERB_DENORMAL_MODE == MK_FREEVERB_DENORMALS_OFFSET
+            blockL[i] = inputL[i * skip] + antidenormal;
+#else
+            blockL[i] = inputL[i * skip];
 #endif
         }
+
+        if constexpr (inputFilterEnabled)
+            inputFilter.process_mono(blockL, numsamples);
+        return true;
+    }
+
+    for (int i = 0; i < numsamples; i++)
+    {
+#if MK_FREEVERB_DENORMAL_MODE == MK_FREEVERB_DENORMALS_OFFSET
+        // Keeps filter, comb and allpass state out of the denormal range
+        blockL[i] = inputL[i * skip] + antidenormal;
+        blockR[i] = inputR[i * skip] + antidenormal;
+#else
+        blockL[i] = inputL[i * skip];
+        blockR[i] = inputR[i * skip];
 #endif
+    }
+
+    // Left and right through the stereo input filter, each with its own state
+    if constexpr (inputFilterEnabled)
+        inputFilter.process(blockL, blockR, numsamples);
+    return false;
+}
 
-        float input = (predelayedL + predelayedR) * gain;
+template <int numcombs_, unsigned features_>
+bool basic_mk_freeverb<numcombs_, features_>::predelay_stage(int numsamples, bool leftOnly)
+{
+    const size_t mask = predelayRingSize - 1;
+    const size_t pos = predelayWrite;
 
-        float outL = 0, outR = 0;
-        for (int i = 0; i < MK_FREEVERB_NUM_COMBS; i++)
+    // Once both rings hold the same samples all round, mono blocks only go
+    // through the left one. The first stereo block after them brings the
+    // right ring up to date with one copy
+    const bool mono = leftOnly && predelayMonoRun >= predelayRingSize;
+    if (mono)
+    {
+        predelayMonoOnly = true;
+    }
+    else
+    {
+        if (predelayMonoOnly)
         {
-            outL += combL[i].process(input);
-            outR += combR[i].process(input);
+            std::memcpy(predelayBufferR, predelayBufferL, predelayRingSize * sizeof(float));
+            predelayMonoOnly = false;
         }
+        if (leftOnly)
+            std::memcpy(blockR, blockL, numsamples * sizeof(float));
+        predelayMonoRun = leftOnly ? std::min(predelayMonoRun + numsamples, predelayRingSize) : 0;
+    }
+
+    // Write first, so a tap shorter than the block reads this block
+    ring_write(predelayBufferL, predelayRingSize, pos, blockL, numsamples);
+    if (!mono)
+        ring_write(predelayBufferR, predelayRingSize, pos, blockR, numsamples);
+    predelayWrite = (pos + numsamples) & mask;
 
-        for (int i = 0; i < numallpasses; i++)
+    int i = 0;
+    if constexpr (crossfadeEnabled)
+    {
+        // Both taps read the same ring; when the fade ends the incoming
+        // tap simply becomes the only one
+        for (; i < numsamples; i++)
         {
-            outL = allpassL[i].process(outL);
-            outR = allpassR[i].process(outR);
-        }
+            if (fadeCount == 0)
+            {
+                if (predelayDelay == predelayTarget) break;
+                // Moves made during a fade start the next one
+                predelayIncoming = predelayTarget;
+                fadeCount = fadeSamples;
+            }
 
-        // Optimize for common case: wet=1.0, dry=0.0 (no dry signal mixing)
-        if (dry == 0.0f) {
-            // Further optimize for wet=1.0, width=1.0 (full wet, full stereo)
-            if (wet == 1.0f && width == 1.0f) {
-                *outputL = outL;  // wet1=1.0, wet2=0.0
-                *outputR = outR;
-            } else {
-                *outputL = outL * wet1 + outR * wet2;
-                *outputR = outR * wet1 + outL * wet2;
+            float fade = static_cast<float>(fadeCount) / fadeSamples;
+            float oldL = ring_tap(predelayBufferL, mask, pos, i, predelayDelay);
+            float newL = ring_tap(predelayBufferL, mask, pos, i, predelayIncoming);
+            blockL[i] = oldL * fade + newL * (1.0f - fade);
+            if (!mono)
+            {
+                float oldR = ring_tap(predelayBufferR, mask, pos, i, predelayDelay);
+                float newR = ring_tap(predelayBufferR, mask, pos, i, predelayIncoming);
+                blockR[i] = oldR * fade + newR * (1.0f - fade);
             }
-        } else {
-            *outputL = outL * wet1 + outR * wet2 + *inputL * dry;
-            *outputR = outR * wet1 + outL * wet2 + *inputR * dry;
+
+            if (--fadeCount == 0)
+                predelayDelay = predelayIncoming;
         }
+        if (i == numsamples) return mono;
+    }
+
+    if (glideCount == 0 && predelayDelay == std::floor(predelayDelay))
+    {
+        const size_t from = (pos + i - static_cast<size_t>(predelayDelay)) & mask;
+        ring_read(predelayBufferL, predelayRingSize, from, blockL + i, numsamples - i);
+        if (!mono)
+            ring_read(predelayBufferR, predelayRingSize, from, blockR + i, numsamples - i);
+        return mono;
+    }
 
-        inputL += skip;
-        inputR += skip;
-        outputL += skip;
-        outputR += skip;
+    for (; i < numsamples; i++)
+    {
+        if (glideCount > 0)
+        {
+            predelayDelay += glideStep;
+            if (--glideCount == 0)
+                predelayDelay = predelayTarget;
+        }
+        blockL[i] = ring_tap(predelayBufferL, mask, pos, i, predelayDelay);
+        if (!mono)
+            blockR[i] = ring_tap(predelayBufferR, mask, pos, i, predelayDelay);
     }
+    return mono;
 }
 
-void mk_freeverb::setRoomSize(float value) { roomSize = value; update(); }
-float mk_freeverb::getRoomSize() { return roomSize; }
+template <int numcombs_, unsigned features_>
+void basic_mk_freeverb<numcombs_, features_>::comb_stage(int numsamples, bool leftOnly)
+{
+    // A mono block sums with itself, exactly like identical left and right
+    const float *blockRight = leftOnly ? blockL : blockR;
+#if MK_FREEVERB_ENABLE_COMB_BANK
+    for (int i = 0; i < numsamples; i++)
+        blockInput[i] = (blockL[i] + blockRight[i]) * gain;
 
-void mk_freeverb::setDamp(float value) { damp = value; update(); }
-float mk_freeverb::getDamp() { return damp; }
+    combs.process_block(blockInput, blockOutL, blockOutR, numsamples);
+#else
+    for (int i = 0; i < numsamples; i++)
+    {
+        blockInput[i] = (blockL[i] + blockRight[i]) * gain;
+        blockOutL[i] = 0;
+        blockOutR[i] = 0;
+    }
 
-void mk_freeverb::setWet(float value) { wet = value; update(); }
-float mk_freeverb::getWet() { return wet; }
+    // One pass per comb - summation order per sample matches the original loop
+    for (int c = 0; c < numcombs_; c++)
+    {
+        combL[c].processmix_block(blockInput, blockOutL, numsamples);
+        combR[c].processmix_block(blockInput, blockOutR, numsamples);
+    }
+#endif
+}
 
-void mk_freeverb::setDry(float value) { dry = value; }
-float mk_freeverb::getDry() { return dry; }
+template <int numcombs_, unsigned features_>
+void basic_mk_freeverb<numcombs_, features_>::allpass_stage(int numsamples)
+{
+    for (int a = 0; a < numallpasses; a++)
+    {
+        allpassL[a].process_block(blockOutL, blockOutL, numsamples);
+        allpassR[a].process_block(blockOutR, blockOutR, numsamples);
+    }
+}
 
-void mk_freeverb::setWidth(float value) { width = value; update(); }
-float mk_freeverb::getWidth() { return width; }
+namespace {
 
-void mk_freeverb::setMode(float value) { mode = value; update(); }
-float mk_freeverb::getMode() { return mode; }
+// Runs vector(i) over the whole vectors of n samples when the outputs are
+// contiguous and one(i) over the rest
+template <typename vector_t, typename one_t>
+inline void mix_loop(int n, int skip, vector_t vector, one_t one)
+{
+    int i = 0;
+    if (skip == 1)
+    {
+        for (; i + MK_FREEVERB_SIMD_WIDTH <= n; i += MK_FREEVERB_SIMD_WIDTH)
+            vector(i);
+    }
+    for (; i < n; i++)
+        one(i);
+}
 
-void mk_freeverb::setLPCutoff(float cutoff)
+// Output mix of one chunk: out = wet mix [+ dry], or out += the same with
+// accumulate. Each form keeps the operation order of the scalar mix, so
+// the vector and scalar paths give the same bits
+template <bool accumulate>
+void mix_block(const float *wetL, const float *wetR, const float *inputL, const float *inputR,
+               float *outputL, float *outputR, int n, int skip, float wet1, float wet2, float dry)
 {
-#if MK_FREEVERB_ENABLE_INPUT_FILTER
-    if (input_filter) {
-        input_filter->setCutoff(cutoff);
+    auto put = [](float *out, float v) { *out = accumulate ? *out + v : v; };
+    auto putv = [](float *out, simd_float v) { simd_storeu(out, accumulate ? simd_add(simd_loadu(out), v) : v); };
+
+    if (dry == 0.0f && wet1 == 1.0f && wet2 == 0.0f)
+    {
+        // Full wet, full width: the allpass output as it is
+        mix_loop(n, skip,
+            [&](int i) {
+                putv(outputL + i, simd_loadu(wetL + i));
+                putv(outputR + i, simd_loadu(wetR + i));
+            },
+            [&](int i) {
+                put(outputL + i * skip, wetL[i]);
+                put(outputR + i * skip, wetR[i]);
+            });
+    }
+    else if (dry == 0.0f)
+    {
+        const simd_float w1 = simd_set1(wet1), w2 = simd_set1(wet2);
+        mix_loop(n, skip,
+            [&](int i) {
+                const simd_float l = simd_loadu(wetL + i), r = simd_loadu(wetR + i);
+                putv(outputL + i, simd_add(simd_mul(l, w1), simd_mul(r, w2)));
+                putv(outputR + i, simd_add(simd_mul(r, w1), simd_mul(l, w2)));
+            },
+            [&](int i) {
+                put(outputL + i * skip, wetL[i] * wet1 + wetR[i] * wet2);
+                put(outputR + i * skip, wetR[i] * wet1 + wetL[i] * wet2);
+            });
+    }
+    else
+    {
+        const simd_float w1 = simd_set1(wet1), w2 = simd_set1(wet2), d = simd_set1(dry);
+        mix_loop(n, skip,
+            [&](int i) {
+                const simd_float l = simd_loadu(wetL + i), r = simd_loadu(wetR + i);
+                putv(outputL + i, simd_add(simd_add(simd_mul(l, w1), simd_mul(r, w2)), simd_mul(simd_loadu(inputL + i), d)));
+                putv(outputR + i, simd_add(simd_add(simd_mul(r, w1), simd_mul(l, w2)), simd_mul(simd_loadu(inputR + i), d)));
+            },
+            [&](int i) {
+                put(outputL + i * skip, wetL[i] * wet1 + wetR[i] * wet2 + inputL[i * skip] * dry);
+                put(outputR + i * skip, wetR[i] * wet1 + wetL[i] * wet2 + inputR[i * skip] * dry);
+            });
     }
-#endif
 }
 
+}
 
-void mk_freeverb::setPredelay(float seconds)
+template <int numcombs_, unsigned features_>
+void basic_mk_freeverb<numcombs_, features_>::mix_stage(const float *wetL, const float *wetR, const float *inputL, const float *inputR,
+                                                        float *outputL, float *outputR, int numsamples, int skip)
 {
-#if MK_FREEVERB_ENABLE_PREDELAY
-    size_t newSize = static_cast<size_t>(sampleRate * seconds);
-    
-    // Clamp to maximum buffer size for RT safety
-    if (newSize > MK_FREEVERB_MAX_PREDELAY_SAMPLES) {
-        newSize = MK_FREEVERB_MAX_PREDELAY_SAMPLES;
+    if (mixAccumulate)
+    {
+        // The send gain is folded into the coefficients, so adding into the
+        // destination costs no extra multiply
+        mix_block<true>(wetL, wetR, inputL, inputR, outputL, outputR, numsamples, skip,
+                        wet1 * mixGain, wet2 * mixGain, dry * mixGain);
     }
-    
-#if MK_FREEVERB_ENABLE_PREDELAY_CROSSFADE
-    // Crossfade version (RT-safe with static buffers)
-    if (newSize == predelaySize) return;
+    else
+    {
+        mix_block<false>(wetL, wetR, inputL, inputR, outputL, outputR, numsamples, skip, wet1, wet2, dry);
+    }
+}
 
-    // Clear new buffer
-    for (size_t i = 0; i < newSize; i++) {
-        predelayBufferL_new[i] = 0.0f;
-        predelayBufferR_new[i] = 0.0f;
+template <int numcombs_, unsigned features_>
+bool basic_mk_freeverb<numcombs_, features_>::steady() const
+{
+#if MK_FREEVERB_ENABLE_SLEEP
+    if (sleeping) return false;
+#endif
+#if MK_FREEVERB_ENABLE_SMOOTHING
+    if (ramping()) return false;
+#endif
+    return true;
+}
+
+template <int numcombs_, unsigned features_>
+long basic_mk_freeverb<numcombs_, features_>::pipeline_span(mk_freeverb_pipeline &pipeline, const float *inputL, const float *inputR,
+                                                            float *outputL, float *outputR, long pos, long end, int skip)
+{
+    // Blocks are cut from pos exactly like the serial loop does
+    spanInputL = inputL + pos * skip;
+    spanInputR = inputR + pos * skip;
+    spanLength = end - pos;
+    spanSkip = skip;
+
+    const long numblocks = (spanLength + MK_FREEVERB_BLOCK_SIZE - 1) / MK_FREEVERB_BLOCK_SIZE;
+    pipeline.start(this, &pipeline_front, &pipeline_channel, numblocks, pipeline_limit(0));
+
+    for (long block = 0; block < numblocks; block++)
+    {
+        mk_freeverb_pipeline_slot &s = pipeline.wait(block);
+        const int n = s.numsamples;
+        const long offset = (pos + block * MK_FREEVERB_BLOCK_SIZE) * skip;
+
+#if MK_FREEVERB_ENABLE_SLEEP
+        track_tail(s.inputQuiet && s.wetQuiet[0] && s.wetQuiet[1], n);
+#endif
+#if MK_FREEVERB_ENABLE_STATS && MK_FREEVERB_DENORMAL_MODE == MK_FREEVERB_DENORMALS_CHECK
+        processStats.add_denormals(s.denormalHits[0] + s.denormalHits[1] + s.denormalHits[2]);
+#endif
+        mix_stage(s.wet[0], s.wet[1], inputL + offset, inputR + offset, outputL + offset, outputR + offset, n, skip);
+        pipeline.release(block, pipeline_limit(block + 1));
+
+#if MK_FREEVERB_ENABLE_SLEEP
+        if (quietSamples >= sleepHold)
+        {
+            // pipeline_limit() kept the front stage from starting any later block
+            pipeline.stop();
+            mute();
+            sleeping = true;
+            return pos + block * MK_FREEVERB_BLOCK_SIZE + n;
+        }
+#endif
     }
-    
-    predelaySize_new = newSize;
-    predelayWrite_new = 0;
-    predelayRead_new = 0;
-    fadeSamples = static_cast<int>(0.02f * sampleRate);  // 20ms crossfade
-    fadeCount = fadeSamples;
+
+    pipeline.stop();
+    return end;
+}
+
+template <int numcombs_, unsigned features_>
+long basic_mk_freeverb<numcombs_, features_>::pipeline_limit(long next) const
+{
+#if MK_FREEVERB_ENABLE_SLEEP
+    // The serial path stops all processing once the tail has been quiet for
+    // sleepHold samples. The front stage may only start blocks that are
+    // processed whatever the blocks before them turn out to be, i.e. those
+    // the tail cannot reach sleepHold before even if all of them are quiet.
+    if (sleepHold == LONG_MAX) return LONG_MAX;
+    long remaining = sleepHold - quietSamples;
+    if (remaining < 1) remaining = 1;   // sleepHold shrank: only the next block is safe
+    return next + (remaining - 1) / MK_FREEVERB_BLOCK_SIZE + 1;
 #else
-    // Simple immediate change (RT-safe, no crossfading)
-    predelaySize = newSize;
-    predelayWrite = 0;
-    predelayRead = 0;
-    
-    // Clear the buffer
-    for (size_t i = 0; i < predelaySize; i++) {
-        predelayBufferL[i] = 0.0f;
-        predelayBufferR[i] = 0.0f;
-    }
+    (void)next;
+    return LONG_MAX;
 #endif
+}
+
+template <int numcombs_, unsigned features_>
+void basic_mk_freeverb<numcombs_, features_>::pipeline_front(void *context, long block, mk_freeverb_pipeline_slot &s)
+{
+    // Front thread only: owns the input filter, predelay and blockL/R during a span
+    basic_mk_freeverb &self = *static_cast<basic_mk_freeverb *>(context);
+    const long offset = block * MK_FREEVERB_BLOCK_SIZE;
+    const int n = self.spanLength - offset < MK_FREEVERB_BLOCK_SIZE ? static_cast<int>(self.spanLength - offset) : MK_FREEVERB_BLOCK_SIZE;
+
+    const bool mono = self.spanInputL == self.spanInputR;
+#if MK_FREEVERB_ENABLE_STATS && MK_FREEVERB_DENORMAL_MODE == MK_FREEVERB_DENORMALS_CHECK
+    const unsigned long long hits = mk_freeverb_denormal_hits;
+#endif
+
+    bool leftOnly = self.input_stage(self.spanInputL + offset * self.spanSkip, self.spanInputR + offset * self.spanSkip,
+                                     n, self.spanSkip, mono);
+#if MK_FREEVERB_ENABLE_SLEEP
+    // As in process_chunk(), both the ring input and the tap must be quiet
+    s.inputQuiet = block_quiet(self.blockL, n) && (leftOnly || block_quiet(self.blockR, n));
+#endif
+    if constexpr (predelayEnabled)
+    {
+        leftOnly = self.predelay_stage(n, leftOnly);
+#if MK_FREEVERB_ENABLE_SLEEP
+        s.inputQuiet = s.inputQuiet && block_quiet(self.blockL, n) && (leftOnly || block_quiet(self.blockR, n));
+#endif
+    }
+    const float *blockRight = leftOnly ? self.blockL : self.blockR;
+    for (int i = 0; i < n; i++)
+        s.input[i] = (self.blockL[i] + blockRight[i]) * self.gain;
+    s.numsamples = n;
+#if MK_FREEVERB_ENABLE_STATS && MK_FREEVERB_DENORMAL_MODE == MK_FREEVERB_DENORMALS_CHECK
+    s.denormalHits[0] = mk_freeverb_denormal_hits - hits;
 #endif
 }
 
-float mk_freeverb::getPredelay()
+template <int numcombs_, unsigned features_>
+void basic_mk_freeverb<numcombs_, features_>::pipeline_channel(void *context, int channel, mk_freeverb_pipeline_slot &s)
 {
-#if MK_FREEVERB_ENABLE_PREDELAY
-    return static_cast<float>(predelaySize) / sampleRate;
+    // One thread per channel: only touches that channel's combs and allpasses
+    basic_mk_freeverb &self = *static_cast<basic_mk_freeverb *>(context);
+    float *wet = s.wet[channel];
+    const int n = s.numsamples;
+#if MK_FREEVERB_ENABLE_STATS && MK_FREEVERB_DENORMAL_MODE == MK_FREEVERB_DENORMALS_CHECK
+    const unsigned long long hits = mk_freeverb_denormal_hits;
+#endif
+
+#if MK_FREEVERB_ENABLE_COMB_BANK
+    self.combs.process_channel_block(channel, s.input, wet, n);
 #else
-    return 0.0f;    
+    comb *combs = channel ? self.combR : self.combL;
+    for (int i = 0; i < n; i++)
+        wet[i] = 0;
+    for (int c = 0; c < numcombs_; c++)
+        combs[c].processmix_block(s.input, wet, n);
+#endif
+#if MK_FREEVERB_ENABLE_SLEEP
+    s.wetQuiet[channel] = block_quiet(wet, n);
+#endif
+
+    allpass *allpasses = channel ? self.allpassR : self.allpassL;
+    for (int a = 0; a < numallpasses; a++)
+        allpasses[a].process_block(wet, wet, n);
+#if MK_FREEVERB_ENABLE_STATS && MK_FREEVERB_DENORMAL_MODE == MK_FREEVERB_DENORMALS_CHECK
+    s.denormalHits[1 + channel] = mk_freeverb_denormal_hits - hits;
 #endif
 }
 
-#if MK_FREEVERB_ENABLE_INPUT_FILTER
-void mk_freeverb::set_input_filter(float cutoff, float resonance)
+template <int numcombs_, unsigned features_>
+void basic_mk_freeverb<numcombs_, features_>::setLPCutoff(float cutoff)
 {
-    // these two lines cause the hard fault
-    if (input_filter) {
-        input_filter->setCutoff(cutoff);
-        input_filter->setResonance(resonance);
-    }
+    if constexpr (inputFilterEnabled)
+        inputFilter.setCutoff(cutoff);
 }
+
+
+template <int numcombs_, unsigned features_>
+void basic_mk_freeverb<numcombs_, features_>::setPredelay(float seconds)
+{
+    if constexpr (!predelayEnabled) return;
+
+    float delay = sampleRate * seconds;
+
+    // Clamp to the ring for RT safety
+    if (!(delay > 0.0f)) delay = 0.0f;
+    if (delay > MK_FREEVERB_MAX_PREDELAY_SAMPLES) delay = MK_FREEVERB_MAX_PREDELAY_SAMPLES;
+
+    // Times within a thousandth of a whole sample read without interpolation
+    const float whole = std::floor(delay + 0.5f);
+    if (std::fabs(delay - whole) < 1e-3f) delay = whole;
+
+    // Only the tap moves; the ring keeps its history. With crossfade the
+    // next block fades towards it, one move at a time
+    if constexpr (crossfadeEnabled)
+    {
+        if (fadeCount == 0)
+            fadeSamples = std::max(1, static_cast<int>(0.02f * sampleRate));  // 20ms crossfade
+    }
+    else
+    {
+        // Moves shorter than predelay_glide samples glide over that many
+        // samples, so a predelay modulated once per block stays continuous
+        // however the calls are split; longer moves jump
+        if (std::fabs(delay - predelayDelay) < predelay_glide)
+        {
+            glideStep = (delay - predelayDelay) / predelay_glide;
+            glideCount = delay != predelayDelay ? predelay_glide : 0;
+        }
+        else
+        {
+            predelayDelay = delay;
+            glideCount = 0;
+        }
+    }
+    predelayTarget = delay;
+
+#if MK_FREEVERB_ENABLE_SLEEP
+    update_sleep_hold();
 #endif
+}
 
-void mk_freeverb::update()
+template <int numcombs_, unsigned features_>
+float basic_mk_freeverb<numcombs_, features_>::getPredelay()
+{
+    return predelayTarget / sampleRate;
+}
+
+template <int numcombs_, unsigned features_>
+void basic_mk_freeverb<numcombs_, features_>::set_input_filter(float cutoff, float resonance)
+{
+    if constexpr (inputFilterEnabled)
+    {
+        inputFilter.setCutoff(cutoff);
+        inputFilter.setResonance(resonance);
+    }
+}
+
+template <int numcombs_, unsigned features_>
+void basic_mk_freeverb<numcombs_, features_>::update()
+{
+    update_wet();
+    update_combs();
+}
+
+template <int numcombs_, unsigned features_>
+void basic_mk_freeverb<numcombs_, features_>::update_wet()
 {
     wet1 = wet * (width / 2 + 0.5f);
     wet2 = wet * ((1 - width) / 2);
 
+#if MK_FREEVERB_ENABLE_SMOOTHING
+    start_ramps();
+    wet1Ramp.set(wet1, primed ? rampTicks : 0);
+    wet2Ramp.set(wet2, primed ? rampTicks : 0);
+    wet1 = wet1Ramp.value;
+    wet2 = wet2Ramp.value;
+#endif
+}
+
+template <int numcombs_, unsigned features_>
+void basic_mk_freeverb<numcombs_, features_>::update_combs()
+{
     if (mode >= freezemode)
     {
         roomSize1 = 1;
@@ -361,72 +1166,235 @@ void mk_freeverb::update()
         gain = fixedgain;
     }
 
-    for (int i = 0; i < MK_FREEVERB_NUM_COMBS; i++)
+#if MK_FREEVERB_ENABLE_SLEEP
+    update_sleep_hold();
+#endif
+
+#if MK_FREEVERB_ENABLE_SMOOTHING
+    start_ramps();
+    feedbackRamp.set(roomSize1, primed ? rampTicks : 0);
+    dampRamp.set(damp1, primed ? rampTicks : 0);
+    set_comb_coefficients(feedbackRamp.value, dampRamp.value);
+#else
+    set_comb_coefficients(roomSize1, damp1);
+#endif
+}
+
+template <int numcombs_, unsigned features_>
+void basic_mk_freeverb<numcombs_, features_>::set_comb_coefficients(float feedback, float damping)
+{
+#if MK_FREEVERB_ENABLE_COMB_BANK
+    combs.setfeedback(feedback);
+    combs.setdamp(damping);
+#else
+    for (int i = 0; i < numcombs_; i++)
     {
-        combL[i].setfeedback(roomSize1);
-        combR[i].setfeedback(roomSize1);
-        combL[i].setdamp(damp1);
-        combR[i].setdamp(damp1);
+        combL[i].setfeedback(feedback);
+        combR[i].setfeedback(feedback);
+        combL[i].setdamp(damping);
+        combR[i].setdamp(damping);
     }
+#endif
 }
 
-void mk_freeverb::queue_preset(float newRoom, float newDamp, float newWet, float newDry,
-                            float newWidth, float newMode
-#if MK_FREEVERB_ENABLE_PREDELAY
-                            , float newPreDelay
-#endif
-#if MK_FREEVERB_ENABLE_INPUT_FILTER
-                            , float newCutoff, float newResonance
+#if MK_FREEVERB_ENABLE_SMOOTHING
+template <int numcombs_, unsigned features_>
+void basic_mk_freeverb<numcombs_, features_>::start_ramps()
+{
+    // A new ramp starts a full control period from now
+    if (!ramping())
+        controlCountdown = MK_FREEVERB_CONTROL_RATE;
+
+    int ticks = static_cast<int>(MK_FREEVERB_SMOOTHING_TIME * sampleRate / MK_FREEVERB_CONTROL_RATE + 0.5f);
+    rampTicks = ticks > 0 ? ticks : 1;
+}
+
+template <int numcombs_, unsigned features_>
+void basic_mk_freeverb<numcombs_, features_>::control_tick()
+{
+    // Only push coefficients that are still moving
+    bool feedbackMoved = feedbackRamp.tick();
+    bool dampMoved = dampRamp.tick();
+    if (feedbackMoved || dampMoved)
+        set_comb_coefficients(feedbackRamp.value, dampRamp.value);
+
+    if (wet1Ramp.tick()) wet1 = wet1Ramp.value;
+    if (wet2Ramp.tick()) wet2 = wet2Ramp.value;
+}
 #endif
-                            )
+
+template <int numcombs_, unsigned features_>
+bool basic_mk_freeverb<numcombs_, features_>::queue_preset(float newRoom, float newDamp, float newWet, float newDry,
+                                                         float newWidth, float newMode, float newPreDelay,
+                                                         float newCutoff, float newResonance)
 {
     // Create temporary preset from individual parameters (legacy compatibility)
-    ReverbPreset legacyPreset(newRoom, newDamp, newWet, newDry, newWidth, newMode
-#if MK_FREEVERB_ENABLE_PREDELAY
-                             , newPreDelay
-#endif
-#if MK_FREEVERB_ENABLE_INPUT_FILTER
-                             , newCutoff, newResonance
-#endif
-                             );
-    
-    queue_preset(legacyPreset);
+    ReverbPreset legacyPreset(newRoom, newDamp, newWet, newDry, newWidth, newMode,
+                              newPreDelay, newCutoff, newResonance);
+
+    return queue_preset(legacyPreset);
 }
 
 // Enhanced preset methods
-void mk_freeverb::apply_preset(const ReverbPreset& preset)
+template <int numcombs_, unsigned features_>
+void basic_mk_freeverb<numcombs_, features_>::apply_preset(const ReverbPreset& preset)
 {
     // Apply immediately (for initialization or non-RT thread)
+#if MK_FREEVERB_ENABLE_SMOOTHING
+    bool wasPrimed = primed;
+    primed = false;
     apply_preset_internal(preset);
+    primed = wasPrimed;
+#else
+    apply_preset_internal(preset);
+#endif
 }
 
-void mk_freeverb::queue_preset(const ReverbPreset& preset)
+template <int numcombs_, unsigned features_>
+bool basic_mk_freeverb<numcombs_, features_>::queue_param(ReverbParamEvent::Param param, float value, int offset)
 {
-    // Queue for RT-safe application in audio thread
-    pendingPreset = preset;
-    presetPending = true;
+    ReverbParamEvent event = { param, value, offset };
+    return events.push(event);
 }
 
-void mk_freeverb::load_preset_by_index(int index)
+template <int numcombs_, unsigned features_>
+bool basic_mk_freeverb<numcombs_, features_>::queue_preset(const ReverbPreset& preset, int offset)
+{
+    // Queue for RT-safe application in audio thread. All fields are
+    // published as one batch, so a preset is never applied half-written.
+    // Fields for stages that are not compiled in are left out.
+    ReverbParamEvent batch[9] = {
+        { ReverbParamEvent::RoomSize, preset.roomSize, offset },
+        { ReverbParamEvent::Damp, preset.damp, offset },
+        { ReverbParamEvent::Wet, preset.wet, offset },
+        { ReverbParamEvent::Dry, preset.dry, offset },
+        { ReverbParamEvent::Width, preset.width, offset },
+        { ReverbParamEvent::Mode, preset.mode, offset },
+    };
+    int count = 6;
+    if constexpr (predelayEnabled)
+        batch[count++] = { ReverbParamEvent::Predelay, preset.predelay, offset };
+    if constexpr (inputFilterEnabled)
+    {
+        batch[count++] = { ReverbParamEvent::Cutoff, preset.cutoff, offset };
+        batch[count++] = { ReverbParamEvent::Resonance, preset.resonance, offset };
+    }
+    return events.push(batch, count);
+}
+
+template <int numcombs_, unsigned features_>
+bool basic_mk_freeverb<numcombs_, features_>::queue_preset_by_index(int index, int offset)
+{
+    return queue_param(ReverbParamEvent::Preset, static_cast<float>(index), offset);
+}
+
+template <int numcombs_, unsigned features_>
+void basic_mk_freeverb<numcombs_, features_>::load_preset_by_index(int index)
 {
     if (index >= 0 && index < ReverbPresets::NUM_PRESETS) {
         apply_preset(*ReverbPresets::ALL_PRESETS[index]);
     }
 }
 
-void mk_freeverb::apply_preset_internal(const ReverbPreset& preset)
+template <int numcombs_, unsigned features_>
+void basic_mk_freeverb<numcombs_, features_>::apply_preset_internal(const ReverbPreset& preset)
 {
+    processStats.add_preset();
     setRoomSize(preset.roomSize);
     setDamp(preset.damp);
     setWet(preset.wet);
     setDry(preset.dry);
     setWidth(preset.width);
     setMode(preset.mode);
-#if MK_FREEVERB_ENABLE_PREDELAY
-    set_predelay(preset.predelay);
-#endif
-#if MK_FREEVERB_ENABLE_INPUT_FILTER
-    
-    set_input_filter(preset.cutoff, preset.resonance);
-#endif
+    if constexpr (predelayEnabled)
+        setPredelay(preset.predelay);
+    if constexpr (inputFilterEnabled)
+        set_input_filter(preset.cutoff, preset.resonance);
+}
+
+// Every supported configuration: 1-8 combs, each with the six distinct
+// feature sets (crossfade without predelay is the same as no predelay)
+#define MK_FREEVERB_INSTANTIATE(n) \
+    template class basic_mk_freeverb<n, ReverbFeatures::None>; \
+    template class basic_mk_freeverb<n, ReverbFeatures::Predelay>; \
+    template class basic_mk_freeverb<n, ReverbFeatures::Predelay | ReverbFeatures::PredelayCrossfade>; \
+    template class basic_mk_freeverb<n, ReverbFeatures::InputFilter>; \
+    template class basic_mk_freeverb<n, ReverbFeatures::Predelay | ReverbFeatures::InputFilter>; \
+    template class basic_mk_freeverb<n, ReverbFeatures::All>;
+
+MK_FREEVERB_INSTANTIATE(1)
+MK_FREEVERB_INSTANTIATE(2)
+MK_FREEVERB_INSTANTIATE(3)
+MK_FREEVERB_INSTANTIATE(4)
+MK_FREEVERB_INSTANTIATE(5)
+MK_FREEVERB_INSTANTIATE(6)
+MK_FREEVERB_INSTANTIATE(7)
+MK_FREEVERB_INSTANTIATE(8)
+
+#undef MK_FREEVERB_INSTANTIATE
+
+namespace {
+
+// Runtime dispatch: one entry per (comb count, feature mask)
+struct Instantiation
+{
+    mk_freeverb_processor *(*create)(float sr, void *arenaMemory, size_t arenaSize, float maxSampleRate);
+    size_t (*arena_bytes)(float maxSampleRate);
+};
+
+template <int numcombs_, unsigned features_>
+mk_freeverb_processor *create_model(float sr, void *arenaMemory, size_t arenaSize, float maxSampleRate)
+{
+    return new mk_freeverb_model<basic_mk_freeverb<numcombs_, features_>>(sr, arenaMemory, arenaSize, maxSampleRate);
+}
+
+template <int numcombs_, unsigned features_>
+constexpr Instantiation instantiation()
+{
+    // Map onto the explicitly instantiated (normalized) feature set
+    using Reverb = basic_mk_freeverb<numcombs_, basic_mk_freeverb<numcombs_, features_>::features>;
+    return { &create_model<numcombs_, Reverb::features>, &Reverb::arena_bytes };
+}
+
+template <int numcombs_>
+constexpr std::array<Instantiation, ReverbFeatures::All + 1> feature_row()
+{
+    return {{
+        instantiation<numcombs_, 0>(), instantiation<numcombs_, 1>(),
+        instantiation<numcombs_, 2>(), instantiation<numcombs_, 3>(),
+        instantiation<numcombs_, 4>(), instantiation<numcombs_, 5>(),
+        instantiation<numcombs_, 6>(), instantiation<numcombs_, 7>(),
+    }};
+}
+
+const std::array<Instantiation, ReverbFeatures::All + 1> instantiations[numcombs] = {
+    feature_row<1>(), feature_row<2>(), feature_row<3>(), feature_row<4>(),
+    feature_row<5>(), feature_row<6>(), feature_row<7>(), feature_row<8>(),
+};
+
+const Instantiation *find_instantiation(int numCombs, unsigned features)
+{
+    if (numCombs < 1 || numCombs > numcombs) return nullptr;
+    return &instantiations[numCombs - 1][features & ReverbFeatures::All];
+}
+
+}
+
+std::unique_ptr<mk_freeverb_processor> make_mk_freeverb(int numCombs, unsigned features, float sr, float maxSampleRate)
+{
+    return make_mk_freeverb(numCombs, features, sr, nullptr, 0, maxSampleRate);
+}
+
+std::unique_ptr<mk_freeverb_processor> make_mk_freeverb(int numCombs, unsigned features, float sr,
+                                                        void *arenaMemory, size_t arenaSize, float maxSampleRate)
+{
+    const Instantiation *inst = find_instantiation(numCombs, features);
+    if (!inst) return nullptr;
+    return std::unique_ptr<mk_freeverb_processor>(inst->create(sr, arenaMemory, arenaSize, maxSampleRate));
+}
+
+size_t mk_freeverb_arena_bytes(int numCombs, unsigned features, float maxSampleRate)
+{
+    const Instantiation *inst = find_instantiation(numCombs, features);
+    return inst ? inst->arena_bytes(maxSampleRate) : 0;
 }
\ No newline at end of file
@@ -2,17 +2,115 @@
 #define _mk_freeverb_
 
 #include "comb.hpp"
+#include "comb_bank.hpp"
 #include "allpass.hpp"
 #include "filter.hpp"
 #include "tuning.h"
 #include "mk_freeverb_config.h"
 #include "mk_freeverb_presets.h"
+#include "spsc_queue.hpp"
+#include "mk_freeverb_stats.hpp"
 #include <memory>
+#include <cstddef>
+#include <cstdint>
 
-class mk_freeverb
+// Smallest power of two >= n
+constexpr size_t mk_freeverb_pow2_at_least(size_t n, size_t p = 1)
 {
+    return p >= n ? p : mk_freeverb_pow2_at_least(n, p * 2);
+}
+
+class mk_freeverb_pipeline;
+struct mk_freeverb_pipeline_slot;
+
+// Parameter change sent from a control thread to the audio thread
+struct ReverbParamEvent
+{
+    enum Param {
+        RoomSize,
+        Damp,
+        Wet,
+        Dry,
+        Width,
+        Mode,
+        Predelay,   // seconds
+        Cutoff,     // Hz
+        Resonance,
+        Preset      // value = index into ReverbPresets::ALL_PRESETS
+    };
+
+    Param param;
+    float value;
+    int offset;     // sample offset into the next processing call
+};
+
+// One source feeding a shared reverb (process_sends): the input scaled by
+// gain. A null right makes it a mono source feeding both channels
+struct ReverbSend
+{
+    const float *left;
+    const float *right;
+    float gain;
+};
+
+// Optional stages, combined into the features_ argument of basic_mk_freeverb
+struct ReverbFeatures
+{
+    enum : unsigned {
+        None = 0,
+        Predelay = 1,
+        PredelayCrossfade = 2,  // only takes effect together with Predelay
+        InputFilter = 4,
+        All = Predelay | PredelayCrossfade | InputFilter,
+
+        // Selected by the MK_FREEVERB_ENABLE_* macros, used by mk_freeverb
+        Default = (MK_FREEVERB_ENABLE_PREDELAY ? Predelay : 0)
+                | (MK_FREEVERB_ENABLE_PREDELAY_CROSSFADE ? PredelayCrossfade : 0)
+                | (MK_FREEVERB_ENABLE_INPUT_FILTER ? InputFilter : 0)
+    };
+};
+
+// Freeverb with the comb count and optional stages fixed at compile time.
+// Every instantiation has its own layout and a processing path with no
+// feature tests; disabled stages are not compiled in. Comb counts 1-8 with
+// any feature set are instantiated in mk_freeverb.cpp.
+template <int numcombs_, unsigned features_>
+class basic_mk_freeverb
+{
+    static_assert(numcombs_ >= 1 && numcombs_ <= numcombs, "comb count must be 1-8");
+
 public:
-    mk_freeverb(float sr = 48000.0f);
+    static constexpr bool predelayEnabled = (features_ & ReverbFeatures::Predelay) != 0;
+    static constexpr bool crossfadeEnabled = predelayEnabled && (features_ & ReverbFeatures::PredelayCrossfade) != 0;
+    static constexpr bool inputFilterEnabled = (features_ & ReverbFeatures::InputFilter) != 0;
+
+    // Predelay ring length: the smallest power of two holding the longest
+    // predelay, one block and the neighbour of a fractional tap, so ring
+    // positions wrap with a mask
+    static constexpr size_t predelayRingSize = mk_freeverb_pow2_at_least(MK_FREEVERB_MAX_PREDELAY_SAMPLES + MK_FREEVERB_BLOCK_SIZE + 1);
+
+    // Features that are actually compiled in (crossfade implies predelay)
+    static constexpr unsigned features = (predelayEnabled ? unsigned(ReverbFeatures::Predelay) : 0u)
+                                       | (crossfadeEnabled ? unsigned(ReverbFeatures::PredelayCrossfade) : 0u)
+                                       | (inputFilterEnabled ? unsigned(ReverbFeatures::InputFilter) : 0u);
+    enum { num_combs = numcombs_ };
+
+    // Delay memory is sized for maxSampleRate (at least sr), so later
+    // set_sample_rate() calls up to that rate never allocate
+    basic_mk_freeverb(float sr = 48000.0f, float maxSampleRate = MK_FREEVERB_MAX_SAMPLE_RATE);
+
+    // Use caller-owned memory for all delay lines (e.g. SRAM/TCM or hugepages).
+    // arenaSize must be at least arena_bytes(maxSampleRate); any alignment is
+    // accepted. If arenaMemory is null or too small, an internal arena is allocated.
+    basic_mk_freeverb(float sr, void *arenaMemory, size_t arenaSize,
+                float maxSampleRate = MK_FREEVERB_MAX_SAMPLE_RATE);
+    ~basic_mk_freeverb();
+
+    basic_mk_freeverb(const basic_mk_freeverb&) = delete;
+    basic_mk_freeverb& operator=(const basic_mk_freeverb&) = delete;
+
+    // Exact delay memory footprint for the compiled configuration
+    static size_t arena_bytes(float maxSampleRate = MK_FREEVERB_MAX_SAMPLE_RATE);
     
     // Initialize with default preset - call this after construction to avoid static init issues
     void initialize();
@@ -21,63 +119,131 @@ public:
 
     void processreplace(float *inputL, float *inputR, float *outputL, float *outputR, long numsamples, int skip);
 
-    void setRoomSize(float value);
-    float getRoomSize();
+    // Non-interleaved block processing, same output as processreplace(..., 1)
+    void process_block(const float *inputL, const float *inputR, float *outputL, float *outputR, int numsamples);
+
+    // Accumulating versions of processreplace()/process_block(), like the
+    // original Freeverb processmix: the output (wet and dry) is scaled by
+    // mixGain and added to outputL/R, e.g. straight into a mix bus
+    void processmix(float *inputL, float *inputR, float *outputL, float *outputR, long numsamples, int skip,
+                    float mixGain = 1.0f);
+    void process_block_mix(const float *inputL, const float *inputR, float *outputL, float *outputR, int numsamples,
+                           float mixGain = 1.0f);
 
-    void setDamp(float value);
-    float getDamp();
+    // Mono source into the stereo reverb, same output as process_block()
+    // with a copy of input on both channels. The input filter and predelay
+    // run once instead of per channel (after a stereo call, once the
+    // filter and predelay no longer hold stereo history). Passing the same
+    // buffer as both inputs to the other process calls does the same
+    void process_mono_in(const float *input, float *outputL, float *outputR, int numsamples);
 
-    void setWet(float value);
-    float getWet();
+    // One reverb shared by several sources, e.g. every part sent to the
+    // same hall: the sends are summed with their gains in one pass, then
+    // processed like a single input. Sends with only mono sources take the
+    // mono input path. All sends share this instance's predelay
+    void process_sends(const ReverbSend *sends, int numSends, float *outputL, float *outputR, int numsamples);
 
-    void setDry(float value);
-    float getDry();
+    // Offline processing on several cores, bit-identical to processreplace().
+    // Stretches without events, parameter ramps or sleep run the input,
+    // left and right stages on the pipeline's threads (see
+    // mk_freeverb_pipeline.hpp); the calling thread mixes the output.
+    // Pays off for long calls, not for real-time block sizes.
+    void process_pipelined(mk_freeverb_pipeline &pipeline, const float *inputL, const float *inputR,
+                           float *outputL, float *outputR, long numsamples, int skip);
 
-    void setWidth(float value);
-    float getWidth();
+    void setRoomSize(float value) { roomSize = value; update_combs(); }
+    float getRoomSize() { return roomSize; }
 
-    void setMode(float value);
-    float getMode();
+    void setDamp(float value) { damp = value; update_combs(); }
+    float getDamp() { return damp; }
+
+    void setWet(float value) { wet = value; update_wet(); }
+    float getWet() { return wet; }
+
+    void setDry(float value) { dry = value; }
+    float getDry() { return dry; }
+
+    void setWidth(float value) { width = value; update_wet(); }
+    float getWidth() { return width; }
+
+    void setMode(float value) { mode = value; update(); }
+    float getMode() { return mode; }
 
     void setLPCutoff(float cutoff);
 
     void setPredelay(float seconds);
     float getPredelay();
 
-#if MK_FREEVERB_ENABLE_INPUT_FILTER
     void set_input_filter(float cutoff, float resonance);
-#endif
 
-    void set_sample_rate(float sr) 
-    { 
-        sampleRate = sr; 
-#if MK_FREEVERB_ENABLE_INPUT_FILTER
-        Filter::Type filter_type = input_filter->getType();
-        input_filter->reset(filter_type, sr);
-#endif
-    }
+    // True while the tail has decayed and DSP is skipped (MK_FREEVERB_ENABLE_SLEEP)
+    bool is_sleeping() const;
+
+    // Stage timings and counters of this instance (MK_FREEVERB_ENABLE_STATS);
+    // read() and reset() may be called from any thread. Blocks spread over
+    // an mk_freeverb_pipeline are not timed
+    mk_freeverb_stats& stats() { return processStats; }
+
+    // Rescales all delay lengths inside the existing arena and clears the tail.
+    // Rates above the constructor's maxSampleRate are clamped to it.
+    void set_sample_rate(float sr);
+    float get_sample_rate() const { return sampleRate; }
+
+    // Lock-free parameter automation (single control thread -> audio thread).
+    // Events are applied in queue order at their sample offset within the
+    // next processreplace()/process_block() call; offsets past its end apply
+    // after its last sample. Returns false if the queue is full.
+    bool queue_param(ReverbParamEvent::Param param, float value, int offset = 0);
 
     // Enhanced preset system
     void apply_preset(const ReverbPreset& preset);
-    void queue_preset(const ReverbPreset& preset);
+    bool queue_preset(const ReverbPreset& preset, int offset = 0);
+    bool queue_preset_by_index(int index, int offset = 0);
     
     // Convenience methods for common presets
     void load_default_preset() { apply_preset(ReverbPresets::DEFAULT_PRESET); }
     void load_preset_by_index(int index);
     
     // Legacy method for backward compatibility (simplified for RT safety)
-    void queue_preset(float newRoom, float newDamp, float newWet, float newDry,
-                      float newWidth, float newMode
-#if MK_FREEVERB_ENABLE_PREDELAY
-                      , float newPreDelay
-#endif
-#if MK_FREEVERB_ENABLE_INPUT_FILTER
-                      , float newCutoff, float newResonance
-#endif
-                      );
+    bool queue_preset(float newRoom, float newDamp, float newWet, float newDry,
+                      float newWidth, float newMode, float newPreDelay = 0.0f,
+                      float newCutoff = 8000.0f, float newResonance = 0.5f);
 
 private:
     void update();
+    void update_combs();
+    void update_wet();
+    void set_comb_coefficients(float feedback, float damping);
+    void run(const float *inputL, const float *inputR, float *outputL, float *outputR, long numsamples, int skip,
+             mk_freeverb_pipeline *pipeline = nullptr, bool accumulate = false, float gain = 1.0f);
+    int apply_events(int first, int count, long position);
+    bool sum_sends(long pos, int numsamples);
+    void setcombbuffers(int index, delay_sample *bufL, int sizeL, delay_sample *bufR, int sizeR);
+    void layout();
+
+    // Block stages, each one pass over at most MK_FREEVERB_BLOCK_SIZE samples
+    void process_chunk(const float *inputL, const float *inputR, float *outputL, float *outputR, int numsamples, int skip);
+    // Mono input (both pointers equal) takes single-channel input and
+    // predelay stages where that gives the same result; they return true
+    // if only blockL was filled
+    bool input_stage(const float *inputL, const float *inputR, int numsamples, int skip, bool mono);
+    bool predelay_stage(int numsamples, bool leftOnly);
+    void comb_stage(int numsamples, bool leftOnly);
+    void allpass_stage(int numsamples);
+    void mix_stage(const float *wetL, const float *wetR, const float *inputL, const float *inputR,
+                   float *outputL, float *outputR, int numsamples, int skip);
+#if MK_FREEVERB_ENABLE_SLEEP
+    void update_sleep_hold();
+    void track_tail(bool quiet, int numsamples);
+#endif
+
+    // Pipelined processing of blocks with constant parameters
+    bool steady() const;
+    long pipeline_span(mk_freeverb_pipeline &pipeline, const float *inputL, const float *inputR,
+                       float *outputL, float *outputR, long pos, long end, int skip);
+    long pipeline_limit(long next) const;
+    static void pipeline_front(void *context, long block, mk_freeverb_pipeline_slot &s);
+    static void pipeline_channel(void *context, int channel, mk_freeverb_pipeline_slot &s);
     void apply_preset_internal(const ReverbPreset& preset);
 
     float gain;
@@ -88,75 +254,278 @@ private:
     float width;
     float mode;
 
+#if MK_FREEVERB_ENABLE_SMOOTHING
+    // Linear ramp, advanced once per control period
+    struct Ramp
+    {
+        float value = 0.0f;
+        float target = 0.0f;
+        float step = 0.0f;
+        int ticks = 0;
+
+        void set(float newTarget, int numTicks)
+        {
+            target = newTarget;
+            if (numTicks <= 0 || newTarget == value) {
+                value = newTarget;
+                ticks = 0;
+            } else {
+                step = (newTarget - value) / numTicks;
+                ticks = numTicks;
+            }
+        }
+
+        bool tick()
+        {
+            if (ticks == 0) return false;
+            value = (--ticks == 0) ? target : value + step;
+            return true;
+        }
+    };
+
+    void start_ramps();
+    void control_tick();
+    bool ramping() const { return feedbackRamp.ticks | dampRamp.ticks | wet1Ramp.ticks | wet2Ramp.ticks; }
+
+    Ramp feedbackRamp, dampRamp, wet1Ramp, wet2Ramp;
+    int rampTicks = 1;              // ramp length in control periods
+    int controlCountdown = MK_FREEVERB_CONTROL_RATE;
+    bool primed = false;            // changes before the first sample jump, not ramp
+#endif
+
     // Comb filters (configurable count)
-    comb combL[MK_FREEVERB_NUM_COMBS];
-    comb combR[MK_FREEVERB_NUM_COMBS];
+#if MK_FREEVERB_ENABLE_COMB_BANK
+    comb_bank<numcombs_> combs;
+#else
+    comb combL[numcombs_];
+    comb combR[numcombs_];
+#endif
 
     // Allpass filters
     allpass allpassL[numallpasses];
     allpass allpassR[numallpasses];
 
-    // Comb buffers (only create what we need)
-    float bufcombL1[combtuningL1];
-    float bufcombR1[combtuningR1];
-    float bufcombL2[combtuningL2];
-    float bufcombR2[combtuningR2];
-    float bufcombL3[combtuningL3];
-    float bufcombR3[combtuningR3];
-    float bufcombL4[combtuningL4];
-    float bufcombR4[combtuningR4];
-#if MK_FREEVERB_NUM_COMBS > 4
-    float bufcombL5[combtuningL5];
-    float bufcombR5[combtuningR5];
-    float bufcombL6[combtuningL6];
-    float bufcombR6[combtuningR6];
-    float bufcombL7[combtuningL7];
-    float bufcombR7[combtuningR7];
-    float bufcombL8[combtuningL8];
-    float bufcombR8[combtuningR8];
-#endif
+    // Delay memory: every comb, allpass and predelay line is carved from
+    // one arena, each line starting on a MK_FREEVERB_ARENA_ALIGN boundary
+    char *arena = nullptr;
+    void *ownedArena = nullptr;
 
-    // Allpass buffers
-    float bufallpassL1[allpasstuningL1];
-    float bufallpassR1[allpasstuningR1];
-    float bufallpassL2[allpasstuningL2];
-    float bufallpassR2[allpasstuningR2];
-    float bufallpassL3[allpasstuningL3];
-    float bufallpassR3[allpasstuningR3];
-    float bufallpassL4[allpasstuningL4];
-    float bufallpassR4[allpasstuningR4];
-
-#if MK_FREEVERB_ENABLE_INPUT_FILTER
-    // Input filter (optional for RT safety)
-    std::shared_ptr<Filter> input_filter = nullptr;
-#endif
+    // Stereo input filter (only used with ReverbFeatures::InputFilter)
+    StereoFilter inputFilter;
 
-#if MK_FREEVERB_ENABLE_PREDELAY
-    // Static predelay buffers (RT-safe)
-    float predelayBufferL[MK_FREEVERB_MAX_PREDELAY_SAMPLES];
-    float predelayBufferR[MK_FREEVERB_MAX_PREDELAY_SAMPLES];
-    size_t predelaySize = 0;
+    // Predelay rings (predelayRingSize samples each, in the arena, only
+    // with ReverbFeatures::Predelay). Every block is written at a fixed
+    // position that only advances; the output is read from a tap
+    // predelayDelay samples behind it
+    float *predelayBufferL = nullptr;
+    float *predelayBufferR = nullptr;
     size_t predelayWrite = 0;
-    size_t predelayRead = 0;
-
-#if MK_FREEVERB_ENABLE_PREDELAY_CROSSFADE
-    // For crossfade - use second static buffer instead of dynamic allocation
-    float predelayBufferL_new[MK_FREEVERB_MAX_PREDELAY_SAMPLES];
-    float predelayBufferR_new[MK_FREEVERB_MAX_PREDELAY_SAMPLES];
-    size_t predelaySize_new = 0;
-    size_t predelayWrite_new = 0;
-    size_t predelayRead_new = 0;
-    int fadeSamples = 0;
+    float predelayDelay = 0.0f;     // tap in use, in samples (may be fractional)
+    float predelayTarget = 0.0f;    // tap requested by setPredelay()
+    float glideStep = 0.0f;         // per-sample tap move while gliding
+    int glideCount = 0;             // glide samples to go
+    size_t predelayMonoRun = predelayRingSize;  // samples written with left == right, up to the ring size
+    bool predelayMonoOnly = false;  // right ring behind: mono blocks since it was written
+
+    // Crossfade from the predelayDelay tap to the predelayIncoming tap
+    // (ReverbFeatures::PredelayCrossfade), fadeCount samples to go
+    float predelayIncoming = 0.0f;
+    int fadeSamples = 1;
     int fadeCount = 0;
-#endif
-#endif
 
-    // Sample rate for timing
+    // Per-block scratch buffers
+    float blockL[MK_FREEVERB_BLOCK_SIZE];
+    float blockR[MK_FREEVERB_BLOCK_SIZE];
+    float blockInput[MK_FREEVERB_BLOCK_SIZE];
+    float blockOutL[MK_FREEVERB_BLOCK_SIZE];
+    float blockOutR[MK_FREEVERB_BLOCK_SIZE];
+
+    // Sources of the current process_sends() call, summed per block into
+    // sendL/R
+    const ReverbSend *sendList = nullptr;
+    int sendCount = 0;
+    float sendL[MK_FREEVERB_BLOCK_SIZE];
+    float sendR[MK_FREEVERB_BLOCK_SIZE];
+
+    // Output mode of the current call: replace, or add scaled by mixGain
+    bool mixAccumulate = false;
+    float mixGain = 1.0f;
+
+    // Input of the span the pipeline's front stage is working on
+    const float *spanInputL = nullptr;
+    const float *spanInputR = nullptr;
+    long spanLength = 0;
+    int spanSkip = 1;
+
+    // Sample rate for timing; delay lines are laid out for maxSampleRate
     float sampleRate = 44100.0f;
+    float maxSampleRate = MK_FREEVERB_MAX_SAMPLE_RATE;
+
+#if MK_FREEVERB_ENABLE_SLEEP
+    // Silence detection: samples the tail has been quiet, and how long it
+    // must stay quiet (derived from room size) before going to sleep
+    long quietSamples = 0;
+    long sleepHold = 0;
+    bool sleeping = false;
+#endif
+
+    // Parameter events from the control thread (RT-safe, lock-free)
+    spsc_queue<ReverbParamEvent, MK_FREEVERB_EVENT_QUEUE_SIZE> events;
+    ReverbParamEvent blockEvents[MK_FREEVERB_MAX_EVENTS_PER_BLOCK];
+    static_assert(MK_FREEVERB_MAX_EVENTS_PER_BLOCK >= 9, "a queue_preset() batch must fit in one call");
 
-    // Enhanced preset handling (RT-safe)
-    bool presetPending = false;
-    ReverbPreset pendingPreset = ReverbPresets::DEFAULT_PRESET;
+    // Written by the audio thread, read by anyone (MK_FREEVERB_ENABLE_STATS)
+    mk_freeverb_stats processStats;
 };
 
+// The configuration selected by the MK_FREEVERB_* macros
+using mk_freeverb = basic_mk_freeverb<MK_FREEVERB_NUM_COMBS, ReverbFeatures::Default>;
+
+// Type-erased reverb: lets each bus or voice choose its comb count and
+// features at run time. Processing costs one virtual call per block.
+class mk_freeverb_processor
+{
+public:
+    virtual ~mk_freeverb_processor() {}
+
+    virtual int num_combs() const = 0;
+    virtual unsigned features() const = 0;
+
+    virtual void mute() = 0;
+    virtual void processreplace(float *inputL, float *inputR, float *outputL, float *outputR, long numsamples, int skip) = 0;
+    virtual void process_block(const float *inputL, const float *inputR, float *outputL, float *outputR, int numsamples) = 0;
+    virtual void process_mono_in(const float *input, float *outputL, float *outputR, int numsamples) = 0;
+    virtual void processmix(float *inputL, float *inputR, float *outputL, float *outputR, long numsamples, int skip,
+                            float mixGain = 1.0f) = 0;
+    virtual void process_block_mix(const float *inputL, const float *inputR, float *outputL, float *outputR, int numsamples,
+                                   float mixGain = 1.0f) = 0;
+    virtual void process_sends(const ReverbSend *sends, int numSends, float *outputL, float *outputR, int numsamples) = 0;
+    virtual void process_pipelined(mk_freeverb_pipeline &pipeline, const float *inputL, const float *inputR,
+                                   float *outputL, float *outputR, long numsamples, int skip) = 0;
+
+    virtual void setRoomSize(float value) = 0;
+    virtual float getRoomSize() = 0;
+    virtual void setDamp(float value) = 0;
+    virtual float getDamp() = 0;
+    virtual void setWet(float value) = 0;
+    virtual float getWet() = 0;
+    virtual void setDry(float value) = 0;
+    virtual float getDry() = 0;
+    virtual void setWidth(float value) = 0;
+    virtual float getWidth() = 0;
+    virtual void setMode(float value) = 0;
+    virtual float getMode() = 0;
+    virtual void setLPCutoff(float cutoff) = 0;
+    virtual void setPredelay(float seconds) = 0;
+    virtual float getPredelay() = 0;
+    virtual void set_input_filter(float cutoff, float resonance) = 0;
+
+    virtual bool is_sleeping() const = 0;
+    virtual mk_freeverb_stats& stats() = 0;
+    virtual void set_sample_rate(float sr) = 0;
+    virtual float get_sample_rate() const = 0;
+
+    virtual bool queue_param(ReverbParamEvent::Param param, float value, int offset = 0) = 0;
+    virtual void apply_preset(const ReverbPreset& preset) = 0;
+    virtual bool queue_preset(const ReverbPreset& preset, int offset = 0) = 0;
+    virtual bool queue_preset_by_index(int index, int offset = 0) = 0;
+    virtual void load_preset_by_index(int index) = 0;
+};
+
+// mk_freeverb_processor implemented by one basic_mk_freeverb instantiation
+template <class Reverb>
+class mk_freeverb_model final : public mk_freeverb_processor
+{
+public:
+    mk_freeverb_model(float sr, float maxSampleRate) : reverb(sr, maxSampleRate) {}
+    mk_freeverb_model(float sr, void *arenaMemory, size_t arenaSize, float maxSampleRate)
+        : reverb(sr, arenaMemory, arenaSize, maxSampleRate) {}
+
+    Reverb& get() { return reverb; }
+
+    int num_combs() const override { return Reverb::num_combs; }
+    unsigned features() const override { return Reverb::features; }
+
+    void mute() override { reverb.mute(); }
+    void processreplace(float *inputL, float *inputR, float *outputL, float *outputR, long numsamples, int skip) override
+    {
+        reverb.processreplace(inputL, inputR, outputL, outputR, numsamples, skip);
+    }
+    void process_block(const float *inputL, const float *inputR, float *outputL, float *outputR, int numsamples) override
+    {
+        reverb.process_block(inputL, inputR, outputL, outputR, numsamples);
+    }
+    void process_mono_in(const float *input, float *outputL, float *outputR, int numsamples) override
+    {
+        reverb.process_mono_in(input, outputL, outputR, numsamples);
+    }
+    void processmix(float *inputL, float *inputR, float *outputL, float *outputR, long numsamples, int skip,
+                    float mixGain = 1.0f) override
+    {
+        reverb.processmix(inputL, inputR, outputL, outputR, numsamples, skip, mixGain);
+    }
+    void process_block_mix(const float *inputL, const float *inputR, float *outputL, float *outputR, int numsamples,
+                           float mixGain = 1.0f) override
+    {
+        reverb.process_block_mix(inputL, inputR, outputL, outputR, numsamples, mixGain);
+    }
+    void process_sends(const ReverbSend *sends, int numSends, float *outputL, float *outputR, int numsamples) override
+    {
+        reverb.process_sends(sends, numSends, outputL, outputR, numsamples);
+    }
+    void process_pipelined(mk_freeverb_pipeline &pipeline, const float *inputL, const float *inputR,
+                           float *outputL, float *outputR, long numsamples, int skip) override
+    {
+        reverb.process_pipelined(pipeline, inputL, inputR, outputL, outputR, numsamples, skip);
+    }
+
+    void setRoomSize(float value) override { reverb.setRoomSize(value); }
+    float getRoomSize() override { return reverb.getRoomSize(); }
+    void setDamp(float value) override { reverb.setDamp(value); }
+    float getDamp() override { return reverb.getDamp(); }
+    void setWet(float value) override { reverb.setWet(value); }
+    float getWet() override { return reverb.getWet(); }
+    void setDry(float value) override { reverb.setDry(value); }
+    float getDry() override { return reverb.getDry(); }
+    void setWidth(float value) override { reverb.setWidth(value); }
+    float getWidth() override { return reverb.getWidth(); }
+    void setMode(float value) override { reverb.setMode(value); }
+    float getMode() override { return reverb.getMode(); }
+    void setLPCutoff(float cutoff) override { reverb.setLPCutoff(cutoff); }
+    void setPredelay(float seconds) override { reverb.setPredelay(seconds); }
+    float getPredelay() override { return reverb.getPredelay(); }
+    void set_input_filter(float cutoff, float resonance) override { reverb.set_input_filter(cutoff, resonance); }
+
+    bool is_sleeping() const override { return reverb.is_sleeping(); }
+    mk_freeverb_stats& stats() override { return reverb.stats(); }
+    void set_sample_rate(float sr) override { reverb.set_sample_rate(sr); }
+    float get_sample_rate() const override { return reverb.get_sample_rate(); }
+
+    bool queue_param(ReverbParamEvent::Param param, float value, int offset = 0) override
+    {
+        return reverb.queue_param(param, value, offset);
+    }
+    void apply_preset(const ReverbPreset& preset) override { reverb.apply_preset(preset); }
+    bool queue_preset(const ReverbPreset& preset, int offset = 0) override { return reverb.queue_preset(preset, offset); }
+    bool queue_preset_by_index(int index, int offset = 0) override { return reverb.queue_preset_by_index(index, offset); }
+    void load_preset_by_index(int index) override { reverb.load_preset_by_index(index); }
+
+private:
+    Reverb reverb;
+};
+
+// Creates the instantiation for numCombs (1-8) and a ReverbFeatures mask.
+// Returns null for an unsupported comb count.
+std::unique_ptr<mk_freeverb_processor> make_mk_freeverb(int numCombs, unsigned features, float sr = 48000.0f,
+                                                        float maxSampleRate = MK_FREEVERB_MAX_SAMPLE_RATE);
+
+// Same, with delay memory supplied by the caller (see basic_mk_freeverb)
+std::unique_ptr<mk_freeverb_processor> make_mk_freeverb(int numCombs, unsigned features, float sr,
+                                                        void *arenaMemory, size_t arenaSize,
+                                                        float maxSampleRate = MK_FREEVERB_MAX_SAMPLE_RATE);
+
+// basic_mk_freeverb<numCombs, features>::arena_bytes(), or 0 if unsupported
+size_t mk_freeverb_arena_bytes(int numCombs, unsigned features,
+                               float maxSampleRate = MK_FREEVERB_MAX_SAMPLE_RATE);
+
 #endif // _mk_freeverb_
\ No newline at end of file
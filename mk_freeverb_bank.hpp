@@ -0,0 +1,438 @@
+#ifndef _mk_freeverb_bank_
+#define _mk_freeverb_bank_
+
+#include "denormals.h"
+#include "simd.h"
+#include "delay_storage.h"
+#include "tuning.h"
+#include "mk_freeverb_config.h"
+#include "mk_freeverb_presets.h"
+
+// N independent reverbs processed together, one instance per SIMD lane.
+//
+// All instances share the comb/allpass tunings, so every delay line is
+// stored lane-interleaved (frame i of instance k at [i * lanes + k]) and
+// one ring index serves all of them. Each comb/allpass step is then a
+// vector load/compute/store across instances. roomSize/damp/wet/dry/
+// width/mode are per instance.
+//
+// The bank runs the comb bank, allpass chain and output mix only; input
+// filter and predelay are not part of it. With those disabled, each lane
+// matches a standalone mk_freeverb with the same parameters, in every
+// denormal mode.
+//
+// Delay lines are sized for MK_FREEVERB_MAX_SAMPLE_RATE and scaled to the
+// running rate like mk_freeverb. The object holds every delay line inline
+// (about 40 KB per instance with 4 combs at 48kHz, 20 KB with 16-bit
+// MK_FREEVERB_DELAY_STORAGE), so allocate it statically or on the heap,
+// not on the stack.
+template <int N, int numcombs_ = MK_FREEVERB_NUM_COMBS>
+class mk_freeverb_bank
+{
+public:
+    enum { lanes = MK_FREEVERB_SIMD_ROUNDUP(N) };
+
+    mk_freeverb_bank(float sr = 48000.0f);
+
+    // Rescales all delay lengths and clears every instance
+    void set_sample_rate(float sr);
+    float get_sample_rate() const { return sampleRate; }
+
+    void mute();
+    void mute(int instance);
+
+    // One pointer per instance for each channel
+    void process(const float *const *inputL, const float *const *inputR,
+                 float *const *outputL, float *const *outputR, int numsamples);
+
+    void setRoomSize(int instance, float value);
+    float getRoomSize(int instance) const { return roomSize[instance]; }
+
+    void setDamp(int instance, float value);
+    float getDamp(int instance) const { return damp[instance]; }
+
+    void setWet(int instance, float value);
+    float getWet(int instance) const { return wet[instance]; }
+
+    void setDry(int instance, float value);
+    float getDry(int instance) const { return dry[instance]; }
+
+    void setWidth(int instance, float value);
+    float getWidth(int instance) const { return width[instance]; }
+
+    void setMode(int instance, float value);
+    float getMode(int instance) const { return mode[instance]; }
+
+    void apply_preset(int instance, const ReverbPreset& preset);
+    void load_preset_by_index(int instance, int index);
+
+private:
+    void update(int instance);
+    void layout();
+    void comb_stage(int numsamples);
+    void allpass_stage(int numsamples);
+
+    static constexpr int comb_frames()
+    {
+        int frames = 0;
+        for (int i = 0; i < numcombs_; i++)
+            frames += scaledtuning(combtuningsL[i], MK_FREEVERB_MAX_SAMPLE_RATE)
+                    + scaledtuning(combtuningsR[i], MK_FREEVERB_MAX_SAMPLE_RATE);
+        return frames;
+    }
+
+    static constexpr int allpass_frames()
+    {
+        int frames = 0;
+        for (int i = 0; i < numallpasses; i++)
+            frames += scaledtuning(allpasstuningsL[i], MK_FREEVERB_MAX_SAMPLE_RATE)
+                    + scaledtuning(allpasstuningsR[i], MK_FREEVERB_MAX_SAMPLE_RATE);
+        return frames;
+    }
+
+    float sampleRate;
+
+    // Per-instance parameters
+    float roomSize[N];
+    float damp[N];
+    float wet[N];
+    float dry[N];
+    float width[N];
+    float mode[N];
+
+    // Per-lane coefficients derived in update()
+    alignas(32) float feedback[lanes];
+    alignas(32) float damp1[lanes];
+    alignas(32) float damp2[lanes];
+    alignas(32) float gain[lanes];
+    float wet1[lanes];
+    float wet2[lanes];
+
+    // Comb lines 0..numcombs-1 feed the left channel, the rest the right
+    delay_sample *combLine[numcombs_ * 2];
+    int combSize[numcombs_ * 2];
+    int combIdx[numcombs_ * 2];
+    alignas(32) float combStore[numcombs_ * 2][lanes];
+
+    delay_sample *allpassLine[numallpasses * 2];
+    int allpassSize[numallpasses * 2];
+    int allpassIdx[numallpasses * 2];
+
+    alignas(32) delay_sample combBuffer[comb_frames() * lanes];
+    alignas(32) delay_sample allpassBuffer[allpass_frames() * lanes];
+
+    // Lane-interleaved per-block scratch
+    alignas(32) float blockInput[MK_FREEVERB_BLOCK_SIZE * lanes];
+    alignas(32) float blockOutL[MK_FREEVERB_BLOCK_SIZE * lanes];
+    alignas(32) float blockOutR[MK_FREEVERB_BLOCK_SIZE * lanes];
+};
+
+template <int N, int numcombs_>
+mk_freeverb_bank<N, numcombs_>::mk_freeverb_bank(float sr)
+    : sampleRate(sr)
+{
+    layout();
+
+    // Padding lanes keep all-zero coefficients and stay silent
+    for (int k = 0; k < lanes; k++)
+    {
+        feedback[k] = damp1[k] = damp2[k] = gain[k] = 0.0f;
+        wet1[k] = wet2[k] = 0.0f;
+    }
+
+    for (int k = 0; k < N; k++)
+    {
+        roomSize[k] = ReverbPresets::DEFAULT_PRESET.roomSize;
+        damp[k] = ReverbPresets::DEFAULT_PRESET.damp;
+        wet[k] = ReverbPresets::DEFAULT_PRESET.wet;
+        dry[k] = ReverbPresets::DEFAULT_PRESET.dry;
+        width[k] = ReverbPresets::DEFAULT_PRESET.width;
+        mode[k] = ReverbPresets::DEFAULT_PRESET.mode;
+        update(k);
+    }
+}
+
+template <int N, int numcombs_>
+void mk_freeverb_bank<N, numcombs_>::layout()
+{
+    // Lines are spaced for the maximum rate, lengths follow the current rate
+    const float rate = sampleRate < MK_FREEVERB_MAX_SAMPLE_RATE ? sampleRate : MK_FREEVERB_MAX_SAMPLE_RATE;
+
+    delay_sample *line = combBuffer;
+    for (int i = 0; i < numcombs_ * 2; i++)
+    {
+        int tuning = i < numcombs_ ? combtuningsL[i] : combtuningsR[i - numcombs_];
+        combSize[i] = scaledtuning(tuning, rate);
+        combLine[i] = line;
+        combIdx[i] = 0;
+        line += scaledtuning(tuning, MK_FREEVERB_MAX_SAMPLE_RATE) * lanes;
+        for (int k = 0; k < lanes; k++)
+            combStore[i][k] = 0.0f;
+    }
+
+    line = allpassBuffer;
+    for (int i = 0; i < numallpasses * 2; i++)
+    {
+        int tuning = i < numallpasses ? allpasstuningsL[i] : allpasstuningsR[i - numallpasses];
+        allpassSize[i] = scaledtuning(tuning, rate);
+        allpassLine[i] = line;
+        allpassIdx[i] = 0;
+        line += scaledtuning(tuning, MK_FREEVERB_MAX_SAMPLE_RATE) * lanes;
+    }
+
+    for (int i = 0; i < comb_frames() * lanes; i++)
+        combBuffer[i] = 0;
+    for (int i = 0; i < allpass_frames() * lanes; i++)
+        allpassBuffer[i] = 0;
+}
+
+template <int N, int numcombs_>
+void mk_freeverb_bank<N, numcombs_>::set_sample_rate(float sr)
+{
+    sampleRate = sr;
+    layout();
+}
+
+template <int N, int numcombs_>
+void mk_freeverb_bank<N, numcombs_>::mute()
+{
+    for (int k = 0; k < N; k++)
+        mute(k);
+}
+
+template <int N, int numcombs_>
+void mk_freeverb_bank<N, numcombs_>::mute(int instance)
+{
+    if (mode[instance] >= freezemode) return;
+
+    for (int i = 0; i < comb_frames(); i++)
+        combBuffer[i * lanes + instance] = 0;
+    for (int i = 0; i < numcombs_ * 2; i++)
+        combStore[i][instance] = 0.0f;
+    for (int i = 0; i < allpass_frames(); i++)
+        allpassBuffer[i * lanes + instance] = 0;
+}
+
+template <int N, int numcombs_>
+void mk_freeverb_bank<N, numcombs_>::process(const float *const *inputL, const float *const *inputR,
+                                             float *const *outputL, float *const *outputR, int numsamples)
+{
+#if MK_FREEVERB_DENORMAL_MODE == MK_FREEVERB_DENORMALS_FTZ
+    denormal_guard ftz;
+#endif
+
+    int offset = 0;
+    while (offset < numsamples)
+    {
+        int n = numsamples - offset;
+        if (n > MK_FREEVERB_BLOCK_SIZE) n = MK_FREEVERB_BLOCK_SIZE;
+
+        // Interleave the mono comb input of every instance
+        for (int i = 0; i < n; i++)
+        {
+            float *frame = blockInput + i * lanes;
+            for (int k = 0; k < N; k++)
+#if MK_FREEVERB_DENORMAL_MODE == MK_FREEVERB_DENORMALS_OFFSET
+                // Offset on each channel before the gain, as in mk_freeverb::input_stage
+                frame[k] = ((inputL[k][offset + i] + antidenormal) + (inputR[k][offset + i] + antidenormal)) * gain[k];
+#else
+                frame[k] = (inputL[k][offset + i] + inputR[k][offset + i]) * gain[k];
+#endif
+            for (int k = N; k < lanes; k++)
+                frame[k] = 0.0f;
+        }
+
+        comb_stage(n);
+        allpass_stage(n);
+
+        // Same mix branches as mk_freeverb::mix_stage, chosen per instance
+        for (int k = 0; k < N; k++)
+        {
+            const float *inL = inputL[k] + offset;
+            const float *inR = inputR[k] + offset;
+            float *outL = outputL[k] + offset;
+            float *outR = outputR[k] + offset;
+
+            if (dry[k] == 0.0f && wet[k] == 1.0f && width[k] == 1.0f)
+            {
+                for (int i = 0; i < n; i++)
+                {
+                    outL[i] = blockOutL[i * lanes + k];
+                    outR[i] = blockOutR[i * lanes + k];
+                }
+            }
+            else if (dry[k] == 0.0f)
+            {
+                for (int i = 0; i < n; i++)
+                {
+                    float wetL = blockOutL[i * lanes + k];
+                    float wetR = blockOutR[i * lanes + k];
+                    outL[i] = wetL * wet1[k] + wetR * wet2[k];
+                    outR[i] = wetR * wet1[k] + wetL * wet2[k];
+                }
+            }
+            else
+            {
+                for (int i = 0; i < n; i++)
+                {
+                    float wetL = blockOutL[i * lanes + k];
+                    float wetR = blockOutR[i * lanes + k];
+                    float dryL = inL[i];
+                    float dryR = inR[i];
+                    outL[i] = wetL * wet1[k] + wetR * wet2[k] + dryL * dry[k];
+                    outR[i] = wetR * wet1[k] + wetL * wet2[k] + dryR * dry[k];
+                }
+            }
+        }
+
+        offset += n;
+    }
+}
+
+template <int N, int numcombs_>
+void mk_freeverb_bank<N, numcombs_>::comb_stage(int numsamples)
+{
+    for (int i = 0; i < numsamples * lanes; i++)
+    {
+        blockOutL[i] = 0.0f;
+        blockOutR[i] = 0.0f;
+    }
+
+    // Combs in order so each lane sums exactly like mk_freeverb
+    for (int c = 0; c < numcombs_ * 2; c++)
+    {
+        float *out = c < numcombs_ ? blockOutL : blockOutR;
+        const float *in = blockInput;
+        int remaining = numsamples;
+
+        while (remaining > 0)
+        {
+            // Run up to the ring wrap point without index checks
+            int len = combSize[c] - combIdx[c];
+            if (len > remaining) len = remaining;
+
+            delay_sample *line = combLine[c] + combIdx[c] * lanes;
+            for (int k = 0; k < lanes; k += MK_FREEVERB_SIMD_WIDTH)
+            {
+                const simd_float fb = simd_load(feedback + k);
+                const simd_float d1 = simd_load(damp1 + k);
+                const simd_float d2 = simd_load(damp2 + k);
+                simd_float store = simd_load(combStore[c] + k);
+
+                for (int i = 0; i < len; i++)
+                {
+                    delay_sample *slot = line + i * lanes + k;
+                    simd_float output = simd_undenormalise(simd_delay_load(slot));
+                    store = simd_undenormalise(simd_add(simd_mul(output, d2), simd_mul(store, d1)));
+                    simd_delay_store(slot, simd_add(simd_load(in + i * lanes + k), simd_mul(store, fb)));
+                    simd_store(out + i * lanes + k, simd_add(simd_load(out + i * lanes + k), output));
+                }
+
+                simd_store(combStore[c] + k, store);
+            }
+
+            combIdx[c] += len;
+            if (combIdx[c] >= combSize[c]) combIdx[c] = 0;
+            in += len * lanes;
+            out += len * lanes;
+            remaining -= len;
+        }
+    }
+}
+
+template <int N, int numcombs_>
+void mk_freeverb_bank<N, numcombs_>::allpass_stage(int numsamples)
+{
+    const simd_float fb = simd_set1(0.5f);
+
+    for (int a = 0; a < numallpasses * 2; a++)
+    {
+        float *buf = a < numallpasses ? blockOutL : blockOutR;
+        int remaining = numsamples;
+
+        while (remaining > 0)
+        {
+            int len = allpassSize[a] - allpassIdx[a];
+            if (len > remaining) len = remaining;
+
+            delay_sample *line = allpassLine[a] + allpassIdx[a] * lanes;
+            for (int i = 0; i < len * lanes; i += MK_FREEVERB_SIMD_WIDTH)
+            {
+                simd_float input = simd_load(buf + i);
+                simd_float bufout = simd_undenormalise(simd_delay_load(line + i));
+                simd_delay_store(line + i, simd_add(input, simd_mul(bufout, fb)));
+                simd_store(buf + i, simd_sub(bufout, input));
+            }
+
+            allpassIdx[a] += len;
+            if (allpassIdx[a] >= allpassSize[a]) allpassIdx[a] = 0;
+            buf += len * lanes;
+            remaining -= len;
+        }
+    }
+}
+
+template <int N, int numcombs_>
+void mk_freeverb_bank<N, numcombs_>::update(int instance)
+{
+    wet1[instance] = wet[instance] * (width[instance] / 2 + 0.5f);
+    wet2[instance] = wet[instance] * ((1 - width[instance]) / 2);
+
+    float roomSize1, damping;
+    if (mode[instance] >= freezemode)
+    {
+        roomSize1 = 1;
+        damping = 0;
+        gain[instance] = muted;
+    }
+    else
+    {
+        roomSize1 = roomSize[instance];
+        damping = damp[instance];
+        gain[instance] = fixedgain;
+    }
+
+    feedback[instance] = roomSize1;
+    damp1[instance] = damping;
+    damp2[instance] = 1 - damping;
+}
+
+template <int N, int numcombs_>
+void mk_freeverb_bank<N, numcombs_>::setRoomSize(int instance, float value) { roomSize[instance] = value; update(instance); }
+
+template <int N, int numcombs_>
+void mk_freeverb_bank<N, numcombs_>::setDamp(int instance, float value) { damp[instance] = value; update(instance); }
+
+template <int N, int numcombs_>
+void mk_freeverb_bank<N, numcombs_>::setWet(int instance, float value) { wet[instance] = value; update(instance); }
+
+template <int N, int numcombs_>
+void mk_freeverb_bank<N, numcombs_>::setDry(int instance, float value) { dry[instance] = value; }
+
+template <int N, int numcombs_>
+void mk_freeverb_bank<N, numcombs_>::setWidth(int instance, float value) { width[instance] = value; update(instance); }
+
+template <int N, int numcombs_>
+void mk_freeverb_bank<N, numcombs_>::setMode(int instance, float value) { mode[instance] = value; update(instance); }
+
+template <int N, int numcombs_>
+void mk_freeverb_bank<N, numcombs_>::apply_preset(int instance, const ReverbPreset& preset)
+{
+    roomSize[instance] = preset.roomSize;
+    damp[instance] = preset.damp;
+    wet[instance] = preset.wet;
+    dry[instance] = preset.dry;
+    width[instance] = preset.width;
+    mode[instance] = preset.mode;
+    update(instance);
+}
+
+template <int N, int numcombs_>
+void mk_freeverb_bank<N, numcombs_>::load_preset_by_index(int instance, int index)
+{
+    if (index >= 0 && index < ReverbPresets::NUM_PRESETS) {
+        apply_preset(instance, *ReverbPresets::ALL_PRESETS[index]);
+    }
+}
+
+#endif // _mk_freeverb_bank_
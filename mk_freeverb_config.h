@@ -3,6 +3,12 @@
 
 // Real-time safety configuration for mk_freeverb
 // Include this file before mk_freeverb.hpp to configure the build
+//
+// MK_FREEVERB_ENABLE_PREDELAY, MK_FREEVERB_ENABLE_PREDELAY_CROSSFADE,
+// MK_FREEVERB_ENABLE_INPUT_FILTER and MK_FREEVERB_NUM_COMBS only select the
+// configuration of the mk_freeverb alias. Other configurations can be used
+// in the same binary through basic_mk_freeverb<combs, ReverbFeatures> or
+// make_mk_freeverb(). The remaining options apply to every instance.
 
 // Enable/disable predelay feature
 // Predelay adds latency and uses significant memory
@@ -13,9 +19,8 @@
 
 // Enable/disable predelay crossfading
 // Crossfading provides smooth predelay time changes but uses more CPU
-// and doubles the predelay memory usage (uses 2 static buffers)
+// while a fade runs (a second read tap on the same predelay ring)
 // Only relevant if MK_FREEVERB_ENABLE_PREDELAY is enabled
-// Now RT-safe with static buffer implementation
 #ifndef MK_FREEVERB_ENABLE_PREDELAY_CROSSFADE
 #define MK_FREEVERB_ENABLE_PREDELAY_CROSSFADE 0
 #endif
@@ -35,14 +40,160 @@
 #define MK_FREEVERB_NUM_COMBS 4
 #endif
 
-// Maximum predelay buffer size in samples
+// Process the comb filters as one structure-of-arrays bank
+// All left and right combs of a sample are updated in parallel SIMD lanes.
+// Disable (0) to run each comb as its own scalar filter
+#ifndef MK_FREEVERB_ENABLE_COMB_BANK
+#define MK_FREEVERB_ENABLE_COMB_BANK 1
+#endif
+
+// Enable/disable SIMD kernels (SSE/AVX on x86, NEON on ARM)
+// When disabled, or when no supported instruction set is available,
+// portable scalar code with identical output is used
+#ifndef MK_FREEVERB_ENABLE_SIMD
+#define MK_FREEVERB_ENABLE_SIMD 1
+#endif
+
+// Highest sample rate the delay memory is sized for, in Hz
+// Comb and allpass lengths are scaled from their 44.1kHz tunings to the
+// running sample rate; memory for this rate is reserved at construction
+// so set_sample_rate() never allocates. Rates above this are clamped.
+// mk_freeverb can also take the maximum as a constructor argument.
+#ifndef MK_FREEVERB_MAX_SAMPLE_RATE
+#define MK_FREEVERB_MAX_SAMPLE_RATE 48000
+#endif
+
+// Denormal handling
+// MK_FREEVERB_DENORMALS_CHECK:  zero denormals in software in every comb and
+//                               allpass step (portable, costs a test per sample)
+// MK_FREEVERB_DENORMALS_FTZ:    set hardware flush-to-zero/denormals-are-zero
+//                               around processing; no per-sample checks
+// MK_FREEVERB_DENORMALS_OFFSET: add a tiny DC offset to the reverb input so
+//                               no state ever decays into the denormal range;
+//                               for FPUs without flush-to-zero
+// Defaults to FTZ where the guard is supported (x86 SSE, ARM with FPU)
+#define MK_FREEVERB_DENORMALS_CHECK 0
+#define MK_FREEVERB_DENORMALS_FTZ 1
+#define MK_FREEVERB_DENORMALS_OFFSET 2
+
+#ifndef MK_FREEVERB_DENORMAL_MODE
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1) || \
+    (defined(__GNUC__) && (defined(__aarch64__) || (defined(__arm__) && defined(__ARM_FP))))
+#define MK_FREEVERB_DENORMAL_MODE MK_FREEVERB_DENORMALS_FTZ
+#else
+#define MK_FREEVERB_DENORMAL_MODE MK_FREEVERB_DENORMALS_CHECK
+#endif
+#endif
+
+// Sample format of the comb and allpass delay lines
+// MK_FREEVERB_DELAY_FLOAT: 32-bit float (bit-exact with the original)
+// MK_FREEVERB_DELAY_INT16: 16-bit integers spanning
+//                          +-MK_FREEVERB_DELAY_INT16_RANGE, saturating
+// MK_FREEVERB_DELAY_FP16:  IEEE half precision
+// The 16-bit formats halve the comb and allpass memory. Filtering stays in
+// float; only delay line loads and stores convert (F16C, SSE2 or NEON when
+// available). Predelay lines are always float.
+#define MK_FREEVERB_DELAY_FLOAT 0
+#define MK_FREEVERB_DELAY_INT16 1
+#define MK_FREEVERB_DELAY_FP16 2
+
+#ifndef MK_FREEVERB_DELAY_STORAGE
+#define MK_FREEVERB_DELAY_STORAGE MK_FREEVERB_DELAY_FLOAT
+#endif
+
+// Full scale of MK_FREEVERB_DELAY_INT16 lines (use a power of two)
+// Full-scale DC on both inputs settles at 1.5 in the comb lines at the
+// largest room size; full-scale noise peaks below 1.0. Each halving of the
+// range lowers the quantisation noise by 6 dB but clips louder material
+#ifndef MK_FREEVERB_DELAY_INT16_RANGE
+#define MK_FREEVERB_DELAY_INT16_RANGE 2.0f
+#endif
+
+// Maximum predelay in samples
 // At 48kHz: 4800 samples = 100ms max predelay
 // At 44.1kHz: 4410 samples = 100ms max predelay
-// Reduce this to save memory if shorter predelays are acceptable
+// Each predelay line is a ring of the next power of two above this plus
+// one block (8192 floats with the defaults). Reduce this to save memory
+// if shorter predelays are acceptable
 #ifndef MK_FREEVERB_MAX_PREDELAY_SAMPLES
 #define MK_FREEVERB_MAX_PREDELAY_SAMPLES 4800
 #endif
 
+// Internal processing block size in samples
+// processreplace()/process_block() split longer buffers into chunks of this
+// size and run each stage (input filter, predelay, combs, allpasses, mix) as
+// its own pass over the chunk. Scratch memory is 7 * this * sizeof(float).
+#ifndef MK_FREEVERB_BLOCK_SIZE
+#define MK_FREEVERB_BLOCK_SIZE 256
+#endif
+
+// Enable/disable parameter smoothing
+// Room size, damping, wet and width changes ramp linearly instead of
+// jumping, which avoids zipper noise under automation. Coefficients are
+// only recomputed at control rate, not per sample
+#ifndef MK_FREEVERB_ENABLE_SMOOTHING
+#define MK_FREEVERB_ENABLE_SMOOTHING 1
+#endif
+
+// Control rate for smoothed parameters, in samples per coefficient update
+#ifndef MK_FREEVERB_CONTROL_RATE
+#define MK_FREEVERB_CONTROL_RATE 16
+#endif
+
+// Ramp time for smoothed parameters in seconds
+#ifndef MK_FREEVERB_SMOOTHING_TIME
+#define MK_FREEVERB_SMOOTHING_TIME 0.02f
+#endif
+
+// Enable/disable automatic sleep on silence
+// When both the signal entering the combs and the comb output stay below
+// MK_FREEVERB_SLEEP_THRESHOLD for long enough for the tail to die away,
+// the reverb clears its state and skips all DSP until input returns
+#ifndef MK_FREEVERB_ENABLE_SLEEP
+#define MK_FREEVERB_ENABLE_SLEEP 1
+#endif
+
+// Peak level below which signals count as silent (1e-5 = -100 dBFS)
+#ifndef MK_FREEVERB_SLEEP_THRESHOLD
+#define MK_FREEVERB_SLEEP_THRESHOLD 1e-5f
+#endif
+
+// Capacity of the lock-free parameter event queue (power of two)
+// Control threads push parameter changes with queue_param()/queue_preset();
+// a full queue rejects new events instead of blocking
+#ifndef MK_FREEVERB_EVENT_QUEUE_SIZE
+#define MK_FREEVERB_EVENT_QUEUE_SIZE 256
+#endif
+
+// Maximum parameter events applied per processing call
+// Bounds the audio thread work under heavy automation; the rest is
+// picked up by the next call. Must hold a whole queue_preset() batch (9)
+#ifndef MK_FREEVERB_MAX_EVENTS_PER_BLOCK
+#define MK_FREEVERB_MAX_EVENTS_PER_BLOCK 64
+#endif
+
+// Blocks in flight in an mk_freeverb_pipeline (offline multi-core path)
+// The input stage may run this many MK_FREEVERB_BLOCK_SIZE blocks ahead of
+// the output mix; each block in flight holds 3 * block size floats
+#ifndef MK_FREEVERB_PIPELINE_DEPTH
+#define MK_FREEVERB_PIPELINE_DEPTH 8
+#endif
+
+// Enable/disable processing statistics (mk_freeverb_stats)
+// Every block's input, predelay, comb, allpass and mix stages are timed
+// with the CPU tick counter and accumulated per instance: totals, worst
+// block, a block time histogram, denormals flushed (check mode) and
+// preset/event counts, readable from any thread. Compiles to nothing at 0
+#ifndef MK_FREEVERB_ENABLE_STATS
+#define MK_FREEVERB_ENABLE_STATS 0
+#endif
+
+// Alignment in bytes of every delay line inside the delay memory arena
+// 64 matches the cache line size of current x86 and ARM cores
+#ifndef MK_FREEVERB_ARENA_ALIGN
+#define MK_FREEVERB_ARENA_ALIGN 64
+#endif
+
 // Preset configurations for common use cases:
 
 // Ultra-light configuration for embedded/RT applications
@@ -0,0 +1,327 @@
+#ifndef _mk_freeverb_fixed_
+#define _mk_freeverb_fixed_
+
+#include "comb_fixed.hpp"
+#include "allpass_fixed.hpp"
+#include "filter_fixed.hpp"
+#include "tuning.h"
+#include "mk_freeverb_config.h"
+#include "mk_freeverb_presets.h"
+
+// Fixed-point reverb for targets without an FPU (or with a slow one).
+//
+// sample_t selects the format: int16_t runs in Q15 with int16 delay lines,
+// half the delay memory of the float reverb; int32_t runs in Q31 with
+// int32 lines. Inputs and outputs use the same format. All per-sample
+// arithmetic is integer with rounding and saturation; floats are only
+// touched when a parameter changes, and by the input biquad while its
+// cutoff or resonance is still moving.
+//
+// Same structure and parameters as mk_freeverb: optional input biquad
+// (one state per channel, stepped towards the preset like the float
+// one), comb bank, allpass chain and output mix, in MK_FREEVERB_BLOCK_SIZE
+// chunks. Predelay, parameter smoothing, the event queue and sleep are not
+// part of it; set parameters from the audio thread.
+//
+// Delay lines are held inline, sized for MK_FREEVERB_MAX_SAMPLE_RATE and
+// scaled to the running rate (the whole object is about 30 KB in Q15 and
+// 60 KB in Q31 with 4 combs and a 48kHz maximum).
+// tools/mk_freeverb_snr.cpp measures both formats against the float path.
+template <typename sample_t, int numcombs_ = MK_FREEVERB_NUM_COMBS, bool inputFilter = false>
+class mk_freeverb_fixed
+{
+    static_assert(numcombs_ >= 1 && numcombs_ <= numcombs, "comb count must be 1-8");
+    typedef typename fixed_format<sample_t>::wide_t wide_t;
+
+public:
+    // Wet and dry gains go up to scalewet/scaledry, so the mix uses Q2.29
+    enum { num_combs = numcombs_, mixbits = 29 };
+
+    mk_freeverb_fixed(float sr = 48000.0f);
+
+    // Rescales all delay lengths and clears the tail
+    void set_sample_rate(float sr);
+    float get_sample_rate() const { return sampleRate; }
+
+    void mute();
+
+    void processreplace(const sample_t *inputL, const sample_t *inputR, sample_t *outputL, sample_t *outputR,
+                        long numsamples, int skip);
+
+    void setRoomSize(float value) { roomSize = value; update(); }
+    float getRoomSize() const { return roomSize; }
+
+    void setDamp(float value) { damp = value; update(); }
+    float getDamp() const { return damp; }
+
+    void setWet(float value) { wet = value; update(); }
+    float getWet() const { return wet; }
+
+    void setDry(float value) { dry = value; update(); }
+    float getDry() const { return dry; }
+
+    void setWidth(float value) { width = value; update(); }
+    float getWidth() const { return width; }
+
+    void setMode(float value) { mode = value; update(); }
+    float getMode() const { return mode; }
+
+    void set_input_filter(float cutoff, float resonance);
+
+    void apply_preset(const ReverbPreset& preset);
+    void load_preset_by_index(int index);
+
+private:
+    void update();
+    void layout();
+    void process_chunk(const sample_t *inputL, const sample_t *inputR, sample_t *outputL, sample_t *outputR,
+                       int numsamples, int skip);
+
+    static constexpr int comb_frames()
+    {
+        int frames = 0;
+        for (int i = 0; i < numcombs_; i++)
+            frames += scaledtuning(combtuningsL[i], MK_FREEVERB_MAX_SAMPLE_RATE)
+                    + scaledtuning(combtuningsR[i], MK_FREEVERB_MAX_SAMPLE_RATE);
+        return frames;
+    }
+
+    static constexpr int allpass_frames()
+    {
+        int frames = 0;
+        for (int i = 0; i < numallpasses; i++)
+            frames += scaledtuning(allpasstuningsL[i], MK_FREEVERB_MAX_SAMPLE_RATE)
+                    + scaledtuning(allpasstuningsR[i], MK_FREEVERB_MAX_SAMPLE_RATE);
+        return frames;
+    }
+
+    float sampleRate;
+    float roomSize, damp, wet, dry, width, mode;
+
+    // Per-sample coefficients derived in update()
+    sample_t gain;
+    int32_t wet1, wet2, dryGain;    // Q2.29
+
+    comb_fixed<sample_t> combL[numcombs_];
+    comb_fixed<sample_t> combR[numcombs_];
+    allpass_fixed<sample_t> allpassL[numallpasses];
+    allpass_fixed<sample_t> allpassR[numallpasses];
+    FixedFilter<sample_t> filterL;
+    FixedFilter<sample_t> filterR;
+
+    sample_t combBuffer[comb_frames()];
+    sample_t allpassBuffer[allpass_frames()];
+
+    // Per-block scratch
+    sample_t blockInput[MK_FREEVERB_BLOCK_SIZE];
+    sample_t blockOutL[MK_FREEVERB_BLOCK_SIZE];
+    sample_t blockOutR[MK_FREEVERB_BLOCK_SIZE];
+};
+
+template <typename sample_t, int numcombs_, bool inputFilter>
+mk_freeverb_fixed<sample_t, numcombs_, inputFilter>::mk_freeverb_fixed(float sr)
+    : sampleRate(sr),
+      filterL(inputFilter ? Filter::Lowpass : Filter::NONE, sr),
+      filterR(inputFilter ? Filter::Lowpass : Filter::NONE, sr)
+{
+    layout();
+
+    for (int i = 0; i < numallpasses; i++)
+    {
+        allpassL[i].setfeedback(0.5f);
+        allpassR[i].setfeedback(0.5f);
+    }
+
+    apply_preset(ReverbPresets::DEFAULT_PRESET);
+}
+
+template <typename sample_t, int numcombs_, bool inputFilter>
+void mk_freeverb_fixed<sample_t, numcombs_, inputFilter>::layout()
+{
+    // Lines are spaced for the maximum rate, lengths follow the current rate
+    const float rate = sampleRate < MK_FREEVERB_MAX_SAMPLE_RATE ? sampleRate : MK_FREEVERB_MAX_SAMPLE_RATE;
+
+    sample_t *line = combBuffer;
+    for (int i = 0; i < numcombs_; i++)
+    {
+        combL[i].setbuffer(line, scaledtuning(combtuningsL[i], rate));
+        line += scaledtuning(combtuningsL[i], MK_FREEVERB_MAX_SAMPLE_RATE);
+        combR[i].setbuffer(line, scaledtuning(combtuningsR[i], rate));
+        line += scaledtuning(combtuningsR[i], MK_FREEVERB_MAX_SAMPLE_RATE);
+    }
+
+    line = allpassBuffer;
+    for (int i = 0; i < numallpasses; i++)
+    {
+        allpassL[i].setbuffer(line, scaledtuning(allpasstuningsL[i], rate));
+        line += scaledtuning(allpasstuningsL[i], MK_FREEVERB_MAX_SAMPLE_RATE);
+        allpassR[i].setbuffer(line, scaledtuning(allpasstuningsR[i], rate));
+        line += scaledtuning(allpasstuningsR[i], MK_FREEVERB_MAX_SAMPLE_RATE);
+    }
+
+    for (int i = 0; i < comb_frames(); i++)
+        combBuffer[i] = 0;
+    for (int i = 0; i < allpass_frames(); i++)
+        allpassBuffer[i] = 0;
+    for (int i = 0; i < numcombs_; i++)
+    {
+        combL[i].mute();
+        combR[i].mute();
+    }
+}
+
+template <typename sample_t, int numcombs_, bool inputFilter>
+void mk_freeverb_fixed<sample_t, numcombs_, inputFilter>::set_sample_rate(float sr)
+{
+    sampleRate = sr;
+    layout();
+
+    if constexpr (inputFilter)
+    {
+        // Keeps cutoff and resonance, clears the filter state
+        filterL.reset(filterL.getType(), sr);
+        filterR.reset(filterR.getType(), sr);
+    }
+}
+
+template <typename sample_t, int numcombs_, bool inputFilter>
+void mk_freeverb_fixed<sample_t, numcombs_, inputFilter>::mute()
+{
+    if (mode >= freezemode) return;
+
+    for (int i = 0; i < numcombs_; i++)
+    {
+        combL[i].mute();
+        combR[i].mute();
+    }
+    for (int i = 0; i < numallpasses; i++)
+    {
+        allpassL[i].mute();
+        allpassR[i].mute();
+    }
+}
+
+template <typename sample_t, int numcombs_, bool inputFilter>
+void mk_freeverb_fixed<sample_t, numcombs_, inputFilter>::processreplace(const sample_t *inputL, const sample_t *inputR,
+                                                                          sample_t *outputL, sample_t *outputR,
+                                                                          long numsamples, int skip)
+{
+    long pos = 0;
+    while (pos < numsamples)
+    {
+        int n = numsamples - pos < MK_FREEVERB_BLOCK_SIZE ? static_cast<int>(numsamples - pos) : MK_FREEVERB_BLOCK_SIZE;
+        process_chunk(inputL + pos * skip, inputR + pos * skip, outputL + pos * skip, outputR + pos * skip, n, skip);
+        pos += n;
+    }
+}
+
+template <typename sample_t, int numcombs_, bool inputFilter>
+void mk_freeverb_fixed<sample_t, numcombs_, inputFilter>::process_chunk(const sample_t *inputL, const sample_t *inputR,
+                                                                         sample_t *outputL, sample_t *outputR,
+                                                                         int numsamples, int skip)
+{
+    const int fracbits = fixed_format<sample_t>::fracbits;
+
+    // Mono comb input, (L + R) * gain with one rounding
+    for (int i = 0; i < numsamples; i++)
+    {
+        sample_t inL = inputL[i * skip];
+        sample_t inR = inputR[i * skip];
+        if constexpr (inputFilter)
+        {
+            inL = filterL.process(inL);
+            inR = filterR.process(inR);
+        }
+        blockInput[i] = fixed_saturate<sample_t>(fixed_round_shift((static_cast<wide_t>(inL) + inR) * gain, fracbits));
+        blockOutL[i] = 0;
+        blockOutR[i] = 0;
+    }
+
+    for (int c = 0; c < numcombs_; c++)
+    {
+        combL[c].processmix_block(blockInput, blockOutL, numsamples);
+        combR[c].processmix_block(blockInput, blockOutR, numsamples);
+    }
+
+    for (int a = 0; a < numallpasses; a++)
+    {
+        allpassL[a].process_block(blockOutL, blockOutL, numsamples);
+        allpassR[a].process_block(blockOutR, blockOutR, numsamples);
+    }
+
+    for (int i = 0; i < numsamples; i++)
+    {
+        const int64_t outL = blockOutL[i];
+        const int64_t outR = blockOutR[i];
+        const int64_t dryL = inputL[i * skip];
+        const int64_t dryR = inputR[i * skip];
+        outputL[i * skip] = fixed_saturate<sample_t>(fixed_round_shift(outL * wet1 + outR * wet2 + dryL * dryGain, mixbits));
+        outputR[i * skip] = fixed_saturate<sample_t>(fixed_round_shift(outR * wet1 + outL * wet2 + dryR * dryGain, mixbits));
+    }
+}
+
+template <typename sample_t, int numcombs_, bool inputFilter>
+void mk_freeverb_fixed<sample_t, numcombs_, inputFilter>::update()
+{
+    wet1 = fixed_from_float<int32_t>(wet * (width / 2 + 0.5f), mixbits);
+    wet2 = fixed_from_float<int32_t>(wet * ((1 - width) / 2), mixbits);
+    dryGain = fixed_from_float<int32_t>(dry, mixbits);
+
+    float feedback, damping;
+    if (mode >= freezemode)
+    {
+        feedback = 1;
+        damping = 0;
+        gain = fixed_sample<sample_t>(muted);
+    }
+    else
+    {
+        feedback = roomSize;
+        damping = damp;
+        gain = fixed_sample<sample_t>(fixedgain);
+    }
+
+    for (int i = 0; i < numcombs_; i++)
+    {
+        combL[i].setfeedback(feedback);
+        combR[i].setfeedback(feedback);
+        combL[i].setdamp(damping);
+        combR[i].setdamp(damping);
+    }
+}
+
+template <typename sample_t, int numcombs_, bool inputFilter>
+void mk_freeverb_fixed<sample_t, numcombs_, inputFilter>::set_input_filter(float cutoff, float resonance)
+{
+    if constexpr (inputFilter)
+    {
+        filterL.setCutoff(cutoff);
+        filterL.setResonance(resonance);
+        filterR.setCutoff(cutoff);
+        filterR.setResonance(resonance);
+    }
+}
+
+template <typename sample_t, int numcombs_, bool inputFilter>
+void mk_freeverb_fixed<sample_t, numcombs_, inputFilter>::apply_preset(const ReverbPreset& preset)
+{
+    roomSize = preset.roomSize;
+    damp = preset.damp;
+    wet = preset.wet;
+    dry = preset.dry;
+    width = preset.width;
+    mode = preset.mode;
+    update();
+    set_input_filter(preset.cutoff, preset.resonance);
+}
+
+template <typename sample_t, int numcombs_, bool inputFilter>
+void mk_freeverb_fixed<sample_t, numcombs_, inputFilter>::load_preset_by_index(int index)
+{
+    if (index >= 0 && index < ReverbPresets::NUM_PRESETS)
+        apply_preset(*ReverbPresets::ALL_PRESETS[index]);
+}
+
+#endif//_mk_freeverb_fixed_
+
+//ends
@@ -0,0 +1,141 @@
+#include "mk_freeverb_pipeline.hpp"
+#include "denormals.h"
+
+namespace {
+
+// Blocks arrive a few microseconds apart, so waiting stages poll the
+// counters and only start yielding the core after a while. Returns false
+// if the run is cancelled first.
+template <class Ready>
+bool spin_until(const std::atomic<bool> &cancel, Ready ready)
+{
+    for (int spins = 0; !ready(); spins++)
+    {
+        if (cancel.load(std::memory_order_acquire)) return false;
+        if (spins >= 64) std::this_thread::yield();
+    }
+    return true;
+}
+
+}
+
+mk_freeverb_pipeline::mk_freeverb_pipeline()
+{
+    finished[0].store(0);
+    finished[1].store(0);
+    for (int i = 0; i < 3; i++)
+        threads[i] = std::thread(&mk_freeverb_pipeline::worker, this, i);
+}
+
+mk_freeverb_pipeline::~mk_freeverb_pipeline()
+{
+    stop();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        quit = true;
+    }
+    wake.notify_all();
+    for (int i = 0; i < 3; i++)
+        threads[i].join();
+}
+
+void mk_freeverb_pipeline::start(void *newContext, front_stage newFront, channel_stage newChannel, long newNumblocks, long newLimit)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        context = newContext;
+        front = newFront;
+        channel = newChannel;
+        numblocks = newNumblocks;
+        produced.store(0, std::memory_order_relaxed);
+        finished[0].store(0, std::memory_order_relaxed);
+        finished[1].store(0, std::memory_order_relaxed);
+        consumed.store(0, std::memory_order_relaxed);
+        limit.store(newLimit, std::memory_order_relaxed);
+        cancel.store(false, std::memory_order_relaxed);
+        idle = 0;
+        generation++;
+    }
+    wake.notify_all();
+}
+
+mk_freeverb_pipeline::slot& mk_freeverb_pipeline::wait(long block)
+{
+    spin_until(cancel, [&] {
+        return finished[0].load(std::memory_order_acquire) > block &&
+               finished[1].load(std::memory_order_acquire) > block;
+    });
+    return slots[block % depth];
+}
+
+void mk_freeverb_pipeline::release(long block, long newLimit)
+{
+    limit.store(newLimit, std::memory_order_release);
+    consumed.store(block + 1, std::memory_order_release);
+}
+
+void mk_freeverb_pipeline::stop()
+{
+    cancel.store(true, std::memory_order_release);
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [&] { return idle == 3; });
+}
+
+void mk_freeverb_pipeline::worker(int stage)
+{
+    unsigned seen = 0;
+    for (;;)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [&] { return quit || generation != seen; });
+            if (quit) return;
+            seen = generation;
+        }
+
+        {
+#if MK_FREEVERB_DENORMAL_MODE == MK_FREEVERB_DENORMALS_FTZ
+            // Same floating point mode as the serial path on every stage
+            denormal_guard ftz;
+#endif
+            if (stage == 0)
+                run_front();
+            else
+                run_channel(stage - 1);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            idle++;
+        }
+        done.notify_all();
+    }
+}
+
+void mk_freeverb_pipeline::run_front()
+{
+    for (long block = 0; block < numblocks; block++)
+    {
+        // Wait for a free slot and for the caller to allow this block
+        if (!spin_until(cancel, [&] {
+                return block < limit.load(std::memory_order_acquire) &&
+                       block < consumed.load(std::memory_order_acquire) + depth;
+            }))
+            return;
+
+        front(context, block, slots[block % depth]);
+        produced.store(block + 1, std::memory_order_release);
+    }
+}
+
+void mk_freeverb_pipeline::run_channel(int index)
+{
+    for (long block = 0; block < numblocks; block++)
+    {
+        if (!spin_until(cancel, [&] { return produced.load(std::memory_order_acquire) > block; }))
+            return;
+
+        channel(context, index, slots[block % depth]);
+        finished[index].store(block + 1, std::memory_order_release);
+    }
+}
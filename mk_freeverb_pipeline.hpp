@@ -0,0 +1,97 @@
+#ifndef MK_FREEVERB_PIPELINE_HPP
+#define MK_FREEVERB_PIPELINE_HPP
+
+#include "mk_freeverb_config.h"
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+// One block in flight between the pipeline stages
+struct alignas(64) mk_freeverb_pipeline_slot
+{
+    int numsamples;
+    bool inputQuiet;        // comb input stayed below the sleep threshold
+    bool wetQuiet[2];       // comb output of each channel did
+    float input[MK_FREEVERB_BLOCK_SIZE];     // mono comb input
+    float wet[2][MK_FREEVERB_BLOCK_SIZE];    // allpass output, left and right
+#if MK_FREEVERB_ENABLE_STATS && MK_FREEVERB_DENORMAL_MODE == MK_FREEVERB_DENORMALS_CHECK
+    unsigned long long denormalHits[3];     // flushed by the front and each channel stage
+#endif
+};
+
+// Worker threads for basic_mk_freeverb::process_pipelined(), for offline
+// rendering of long streams. Each block of a call passes through three
+// stages on their own threads:
+//
+//   front:      input filter, predelay and comb input (one thread)
+//   channel 0:  left combs and allpasses
+//   channel 1:  right combs and allpasses
+//
+// while the calling thread mixes the finished blocks into the output.
+// Blocks are handed over through a ring of MK_FREEVERB_PIPELINE_DEPTH slots
+// and atomic counters; the mutex is only taken to start and stop a run.
+//
+// A pipeline serves one reverb at a time and can be reused for any number
+// of calls and reverbs.
+class mk_freeverb_pipeline
+{
+public:
+    typedef mk_freeverb_pipeline_slot slot;
+    typedef void (*front_stage)(void *context, long block, slot &s);
+    typedef void (*channel_stage)(void *context, int channel, slot &s);
+
+    enum { depth = MK_FREEVERB_PIPELINE_DEPTH };
+
+    mk_freeverb_pipeline();
+    ~mk_freeverb_pipeline();
+
+    mk_freeverb_pipeline(const mk_freeverb_pipeline&) = delete;
+    mk_freeverb_pipeline& operator=(const mk_freeverb_pipeline&) = delete;
+
+    // Runs blocks [0, numblocks) through the stages. The front stage only
+    // starts blocks below limit (see release()).
+    void start(void *context, front_stage front, channel_stage channel, long numblocks, long limit);
+
+    // Waits until both channels are done with block and returns its slot
+    slot& wait(long block);
+
+    // Hands the slot of block back to the front stage and lets it start
+    // blocks below limit
+    void release(long block, long limit);
+
+    // Abandons blocks the front stage has not started and waits until all
+    // workers are idle
+    void stop();
+
+private:
+    void worker(int stage);
+    void run_front();
+    void run_channel(int channel);
+
+    void *context = nullptr;
+    front_stage front = nullptr;
+    channel_stage channel = nullptr;
+    long numblocks = 0;
+
+    slot slots[depth];
+
+    // Handoff counters, each on its own cache line
+    alignas(64) std::atomic<long> produced{0};     // blocks done by the front stage
+    alignas(64) std::atomic<long> finished[2];     // blocks done by each channel
+    alignas(64) std::atomic<long> consumed{0};     // blocks released by the caller
+    alignas(64) std::atomic<long> limit{0};
+    alignas(64) std::atomic<bool> cancel{false};
+
+    // Start/stop of a run
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    unsigned generation = 0;
+    int idle = 3;
+    bool quit = false;
+
+    std::thread threads[3];
+};
+
+#endif // MK_FREEVERB_PIPELINE_HPP
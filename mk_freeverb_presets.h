@@ -4,40 +4,24 @@
 #include "mk_freeverb_config.h"
 
 // Reverb preset structure
+// All fields are always present so the layout does not depend on the build
+// configuration; reverbs without predelay or input filter ignore those fields
 struct ReverbPreset {
-    // Core parameters (always available)
     float roomSize;
     float damp;
     float wet;
     float dry;
     float width;
     float mode;
-    
-#if MK_FREEVERB_ENABLE_PREDELAY
     float predelay;  // in seconds
-#endif
-
-#if MK_FREEVERB_ENABLE_INPUT_FILTER
     float cutoff;    // Hz
     float resonance; // 0.0 - 1.0
-#endif
 
     // Constructor for easy initialization
-    ReverbPreset(float r, float d, float w, float dr, float wi, float m
-#if MK_FREEVERB_ENABLE_PREDELAY
-                , float pd = 0.0f
-#endif
-#if MK_FREEVERB_ENABLE_INPUT_FILTER
-                , float cf = 8000.0f, float res = 0.5f
-#endif
-                )
-        : roomSize(r), damp(d), wet(w), dry(dr), width(wi), mode(m)
-#if MK_FREEVERB_ENABLE_PREDELAY
-        , predelay(pd)
-#endif
-#if MK_FREEVERB_ENABLE_INPUT_FILTER
-        , cutoff(cf), resonance(res)
-#endif
+    ReverbPreset(float r, float d, float w, float dr, float wi, float m,
+                 float pd = 0.0f, float cf = 8000.0f, float res = 0.5f)
+        : roomSize(r), damp(d), wet(w), dry(dr), width(wi), mode(m),
+          predelay(pd), cutoff(cf), resonance(res)
     {}
 };
 
@@ -51,13 +35,9 @@ namespace ReverbPresets {
         1.0f,   // wet
         0.0f,   // dry
         1.0f,   // width
-        0.0f    // mode (freeze)
-#if MK_FREEVERB_ENABLE_PREDELAY
-        , 0.0f  // predelay (no predelay by default)
-#endif
-#if MK_FREEVERB_ENABLE_INPUT_FILTER
-        , 2000.0f, 0.0f  // cutoff, resonance
-#endif
+        0.0f,   // mode (freeze)
+        0.0f,  // predelay (no predelay by default)
+        2000.0f, 0.0f  // cutoff, resonance
     );
 
     // Small room - tight, controlled reverb
@@ -67,13 +47,9 @@ namespace ReverbPresets {
         1.0f,  // wet
         0.0f,  // dry
         0.8f,   // width
-        0.0f    // mode
-#if MK_FREEVERB_ENABLE_PREDELAY
-        , 0.005f  // 5ms predelay
-#endif
-#if MK_FREEVERB_ENABLE_INPUT_FILTER
-        , 6000.0f, 0.3f  // slightly darker for intimate sound
-#endif
+        0.0f,   // mode
+        0.005f,  // 5ms predelay
+        6000.0f, 0.3f  // slightly darker for intimate sound
     );
 
     // Medium hall - balanced reverb
@@ -83,13 +59,9 @@ namespace ReverbPresets {
         1.0f,   // wet
         0.0f,   // dry
         1.0f,   // width
-        0.0f    // mode
-#if MK_FREEVERB_ENABLE_PREDELAY
-        , 0.015f  // 15ms predelay
-#endif
-#if MK_FREEVERB_ENABLE_INPUT_FILTER
-        , 8000.0f, 0.4f
-#endif
+        0.0f,   // mode
+        0.015f,  // 15ms predelay
+        8000.0f, 0.4f
     );
 
     // Large cathedral - spacious, long reverb
@@ -99,13 +71,9 @@ namespace ReverbPresets {
         1.0f,   // wet
         0.0f,   // dry
         1.0f,   // width
-        0.0f    // mode
-#if MK_FREEVERB_ENABLE_PREDELAY
-        , 0.035f  // 35ms predelay
-#endif
-#if MK_FREEVERB_ENABLE_INPUT_FILTER
-        , 10000.0f, 0.3f  // brighter for spacious feel
-#endif
+        0.0f,   // mode
+        0.035f,  // 35ms predelay
+        10000.0f, 0.3f  // brighter for spacious feel
     );
 
     // Plate reverb - vintage, metallic character
@@ -115,13 +83,9 @@ namespace ReverbPresets {
         1.0f,   // wet
         0.0f,   // dry
         0.9f,   // width (slightly narrower)
-        0.0f    // mode
-#if MK_FREEVERB_ENABLE_PREDELAY
-        , 0.002f  // very short predelay
-#endif
-#if MK_FREEVERB_ENABLE_INPUT_FILTER
-        , 12000.0f, 0.6f  // brighter, more resonant
-#endif
+        0.0f,   // mode
+        0.002f,  // very short predelay
+        12000.0f, 0.6f  // brighter, more resonant
     );
 
     // Spring reverb - surf/vintage amp sound
@@ -131,13 +95,9 @@ namespace ReverbPresets {
         1.0f,   // wet
         0.0f,   // dry
         0.7f,   // width (narrower stereo field)
-        0.0f    // mode
-#if MK_FREEVERB_ENABLE_PREDELAY
-        , 0.001f  // minimal predelay
-#endif
-#if MK_FREEVERB_ENABLE_INPUT_FILTER
-        , 5000.0f, 0.8f  // darker, more resonant
-#endif
+        0.0f,   // mode
+        0.001f,  // minimal predelay
+        5000.0f, 0.8f  // darker, more resonant
     );
 
     // Ambient/pad - lush, washy reverb
@@ -147,13 +107,9 @@ namespace ReverbPresets {
         1.0f,   // wet (mostly reverb)
         0.0f,   // dry
         1.0f,   // width
-        0.0f    // mode
-#if MK_FREEVERB_ENABLE_PREDELAY
-        , 0.025f  // 25ms predelay
-#endif
-#if MK_FREEVERB_ENABLE_INPUT_FILTER
-        , 9000.0f, 0.2f  // open and airy
-#endif
+        0.0f,   // mode
+        0.025f,  // 25ms predelay
+        9000.0f, 0.2f  // open and airy
     );
 
     // Freeze mode - infinite sustain
@@ -163,13 +119,9 @@ namespace ReverbPresets {
         1.0f,   // wet
         0.0f,   // dry
         1.0f,   // width
-        1.0f    // mode (freeze!)
-#if MK_FREEVERB_ENABLE_PREDELAY
-        , 0.0f  // no predelay for freeze
-#endif
-#if MK_FREEVERB_ENABLE_INPUT_FILTER
-        , 8000.0f, 0.3f
-#endif
+        1.0f,   // mode (freeze!)
+        0.0f,  // no predelay for freeze
+        8000.0f, 0.3f
     );
 
     // Array of all presets for easy iteration (defined in mk_freeverb_presets.cpp)
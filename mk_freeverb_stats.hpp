@@ -0,0 +1,214 @@
+#ifndef MK_FREEVERB_STATS_HPP
+#define MK_FREEVERB_STATS_HPP
+
+#include "mk_freeverb_config.h"
+#include "denormals.h"
+#include <atomic>
+#include <cstdint>
+
+#if MK_FREEVERB_ENABLE_STATS
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#elif !defined(__aarch64__)
+#include <chrono>
+#endif
+#endif
+
+// Stages timed by mk_freeverb_stats, in processing order
+struct ReverbStage
+{
+    enum Stage {
+        Input,      // input copy and input filter
+        Predelay,
+        Combs,
+        Allpasses,
+        Mix,
+        NumStages
+    };
+};
+
+// Cheapest monotonic counter of the target: the time stamp counter on x86,
+// the generic timer (CNTVCT_EL0) on AArch64, nanoseconds elsewhere.
+// Only used for differences within one thread.
+inline uint64_t mk_freeverb_ticks() {
+#if !MK_FREEVERB_ENABLE_STATS
+    return 0;
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    return __rdtsc();
+#elif defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#elif defined(__aarch64__)
+    uint64_t ticks;
+    __asm__ __volatile__("mrs %0, cntvct_el0" : "=r"(ticks));
+    return ticks;
+#else
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+}
+
+// Per-instance processing statistics (MK_FREEVERB_ENABLE_STATS)
+//
+// The audio thread is the only writer of the block counters; each one is
+// a relaxed atomic, so any other thread can call read() at any time
+// without locks. A snapshot is consistent per counter, not across them.
+// reset() only raises a flag that the audio thread acts on at the next
+// block. Ticks are in mk_freeverb_ticks() units.
+//
+// With MK_FREEVERB_ENABLE_STATS 0 the class is empty, every call compiles
+// to nothing and read() returns zeros.
+class mk_freeverb_stats
+{
+public:
+    // Block times go into power-of-two buckets: bucket b counts blocks
+    // of [2^b, 2^(b+1)) ticks
+    static const int histogramBuckets = 32;
+
+    struct snapshot {
+        uint64_t blocks = 0;
+        uint64_t samples = 0;
+        uint64_t stageTicks[ReverbStage::NumStages] = {};   // total per stage
+        uint64_t stageWorst[ReverbStage::NumStages] = {};   // slowest block per stage
+        uint64_t blockWorst = 0;                            // slowest block, all stages
+        uint64_t histogram[histogramBuckets] = {};
+        uint64_t denormalHits = 0;      // samples flushed by undenormalise, pipeline workers included
+        uint64_t presetApplies = 0;
+        uint64_t eventsApplied = 0;
+    };
+
+    // Times the stages of one block: lap() charges the time since the
+    // previous lap (or construction) to a stage
+    class block_timer {
+    public:
+#if MK_FREEVERB_ENABLE_STATS
+        block_timer() : last_(mk_freeverb_ticks()) {
+#if MK_FREEVERB_DENORMAL_MODE == MK_FREEVERB_DENORMALS_CHECK
+            denormals_ = mk_freeverb_denormal_hits;
+#endif
+        }
+
+        void lap(ReverbStage::Stage stage) {
+            const uint64_t now = mk_freeverb_ticks();
+            ticks_[stage] += now - last_;
+            last_ = now;
+        }
+
+    private:
+        friend class mk_freeverb_stats;
+        uint64_t last_;
+        uint64_t ticks_[ReverbStage::NumStages] = {};
+        uint64_t denormals_ = 0;
+#else
+        void lap(ReverbStage::Stage) {}
+#endif
+    };
+
+#if MK_FREEVERB_ENABLE_STATS
+    // Audio thread: adds a finished block
+    void add_block(const block_timer &timer, int numsamples) {
+        if (resetRequested_.load(std::memory_order_relaxed)) {
+            clear();
+            resetRequested_.store(false, std::memory_order_relaxed);
+        }
+
+        uint64_t total = 0;
+        for (int s = 0; s < ReverbStage::NumStages; s++) {
+            const uint64_t ticks = timer.ticks_[s];
+            bump(stageTicks_[s], ticks);
+            raise(stageWorst_[s], ticks);
+            total += ticks;
+        }
+        raise(blockWorst_, total);
+
+        int bucket = 0;
+        while (bucket < histogramBuckets - 1 && (total >> (bucket + 1)) != 0) bucket++;
+        bump(histogram_[bucket], 1);
+
+        bump(blocks_, 1);
+        bump(samples_, static_cast<uint64_t>(numsamples));
+#if MK_FREEVERB_DENORMAL_MODE == MK_FREEVERB_DENORMALS_CHECK
+        bump(denormalHits_, mk_freeverb_denormal_hits - timer.denormals_);
+#endif
+    }
+
+    // Audio thread, like add_block(): apply_events() and the preset setters,
+    // which are no more callable during a block than any other setter
+    void add_preset() { bump(presetApplies_, 1); }
+    void add_events(int count) { bump(eventsApplied_, static_cast<uint64_t>(count)); }
+
+    // Audio thread: undenormalise flushes counted on other threads, which
+    // mk_freeverb_denormal_hits (thread_local) does not see
+    void add_denormals(uint64_t count) { bump(denormalHits_, count); }
+
+    // Any thread
+    snapshot read() const {
+        snapshot s;
+        s.blocks = blocks_.load(std::memory_order_relaxed);
+        s.samples = samples_.load(std::memory_order_relaxed);
+        for (int i = 0; i < ReverbStage::NumStages; i++) {
+            s.stageTicks[i] = stageTicks_[i].load(std::memory_order_relaxed);
+            s.stageWorst[i] = stageWorst_[i].load(std::memory_order_relaxed);
+        }
+        s.blockWorst = blockWorst_.load(std::memory_order_relaxed);
+        for (int i = 0; i < histogramBuckets; i++) {
+            s.histogram[i] = histogram_[i].load(std::memory_order_relaxed);
+        }
+        s.denormalHits = denormalHits_.load(std::memory_order_relaxed);
+        s.presetApplies = presetApplies_.load(std::memory_order_relaxed);
+        s.eventsApplied = eventsApplied_.load(std::memory_order_relaxed);
+        return s;
+    }
+
+    void reset() { resetRequested_.store(true, std::memory_order_relaxed); }
+
+private:
+    // Single writer: a plain load and store instead of a locked add
+    static void bump(std::atomic<uint64_t> &counter, uint64_t value) {
+        counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+
+    static void raise(std::atomic<uint64_t> &counter, uint64_t value) {
+        if (value > counter.load(std::memory_order_relaxed)) {
+            counter.store(value, std::memory_order_relaxed);
+        }
+    }
+
+    void clear() {
+        blocks_.store(0, std::memory_order_relaxed);
+        samples_.store(0, std::memory_order_relaxed);
+        for (int i = 0; i < ReverbStage::NumStages; i++) {
+            stageTicks_[i].store(0, std::memory_order_relaxed);
+            stageWorst_[i].store(0, std::memory_order_relaxed);
+        }
+        blockWorst_.store(0, std::memory_order_relaxed);
+        for (int i = 0; i < histogramBuckets; i++) {
+            histogram_[i].store(0, std::memory_order_relaxed);
+        }
+        denormalHits_.store(0, std::memory_order_relaxed);
+        presetApplies_.store(0, std::memory_order_relaxed);
+        eventsApplied_.store(0, std::memory_order_relaxed);
+    }
+
+    std::atomic<uint64_t> blocks_{0};
+    std::atomic<uint64_t> samples_{0};
+    std::atomic<uint64_t> stageTicks_[ReverbStage::NumStages] = {};
+    std::atomic<uint64_t> stageWorst_[ReverbStage::NumStages] = {};
+    std::atomic<uint64_t> blockWorst_{0};
+    std::atomic<uint64_t> histogram_[histogramBuckets] = {};
+    std::atomic<uint64_t> denormalHits_{0};
+    std::atomic<uint64_t> presetApplies_{0};
+    std::atomic<uint64_t> eventsApplied_{0};
+    std::atomic<bool> resetRequested_{false};
+#else
+    void add_block(const block_timer &, int) {}
+    void add_preset() {}
+    void add_events(int) {}
+    void add_denormals(uint64_t) {}
+    snapshot read() const { return snapshot(); }
+    void reset() {}
+#endif
+};
+
+#endif // MK_FREEVERB_STATS_HPP
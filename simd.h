@@ -0,0 +1,156 @@
+// SIMD instruction set selection for mk_freeverb kernels
+//
+// Exactly one of MK_FREEVERB_SIMD_AVX, MK_FREEVERB_SIMD_SSE,
+// MK_FREEVERB_SIMD_NEON or MK_FREEVERB_SIMD_SCALAR is defined to 1.
+// MK_FREEVERB_SIMD_WIDTH is the number of float lanes per vector.
+
+#ifndef _mk_freeverb_simd_
+#define _mk_freeverb_simd_
+
+#include "mk_freeverb_config.h"
+#include "denormals.h"
+
+#if MK_FREEVERB_ENABLE_SIMD && defined(__AVX__)
+#include <immintrin.h>
+#define MK_FREEVERB_SIMD_AVX	1
+#define MK_FREEVERB_SIMD_WIDTH	8
+#elif MK_FREEVERB_ENABLE_SIMD && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#include <emmintrin.h>
+#define MK_FREEVERB_SIMD_SSE	1
+#define MK_FREEVERB_SIMD_WIDTH	4
+#elif MK_FREEVERB_ENABLE_SIMD && (defined(__ARM_NEON) || defined(__ARM_NEON__))
+#include <arm_neon.h>
+#define MK_FREEVERB_SIMD_NEON	1
+#define MK_FREEVERB_SIMD_WIDTH	4
+#else
+#define MK_FREEVERB_SIMD_SCALAR	1
+#define MK_FREEVERB_SIMD_WIDTH	4
+#endif
+
+// Round a lane count up to a whole number of vectors
+#define MK_FREEVERB_SIMD_ROUNDUP(n) ((((n) + MK_FREEVERB_SIMD_WIDTH - 1) / MK_FREEVERB_SIMD_WIDTH) * MK_FREEVERB_SIMD_WIDTH)
+
+// Vector helpers used by the lane-parallel kernels. Loads and stores are
+// aligned to the vector width; simd_loadu/simd_storeu take any address. Multiply and add are never fused, so
+// results match the scalar filters bit for bit. simd_undenormalise has
+// the same effect as the undenormalise macro on every lane, including
+// compiling to nothing outside MK_FREEVERB_DENORMALS_CHECK mode.
+
+#if MK_FREEVERB_SIMD_AVX
+typedef __m256 simd_float;
+static inline simd_float simd_load(const float *p) { return _mm256_load_ps(p); }
+static inline void simd_store(float *p, simd_float v) { _mm256_store_ps(p, v); }
+static inline simd_float simd_loadu(const float *p) { return _mm256_loadu_ps(p); }
+static inline void simd_storeu(float *p, simd_float v) { _mm256_storeu_ps(p, v); }
+static inline simd_float simd_set1(float v) { return _mm256_set1_ps(v); }
+static inline simd_float simd_add(simd_float a, simd_float b) { return _mm256_add_ps(a, b); }
+static inline simd_float simd_sub(simd_float a, simd_float b) { return _mm256_sub_ps(a, b); }
+static inline simd_float simd_mul(simd_float a, simd_float b) { return _mm256_mul_ps(a, b); }
+#if MK_FREEVERB_DENORMAL_MODE == MK_FREEVERB_DENORMALS_CHECK
+static inline simd_float simd_flush_denormals(simd_float v)
+{
+	const __m256 expmask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7f800000));
+	return _mm256_and_ps(v, _mm256_cmp_ps(_mm256_and_ps(v, expmask), _mm256_setzero_ps(), _CMP_NEQ_UQ));
+}
+#endif
+#elif MK_FREEVERB_SIMD_SSE
+typedef __m128 simd_float;
+static inline simd_float simd_load(const float *p) { return _mm_load_ps(p); }
+static inline void simd_store(float *p, simd_float v) { _mm_store_ps(p, v); }
+static inline simd_float simd_loadu(const float *p) { return _mm_loadu_ps(p); }
+static inline void simd_storeu(float *p, simd_float v) { _mm_storeu_ps(p, v); }
+static inline simd_float simd_set1(float v) { return _mm_set1_ps(v); }
+static inline simd_float simd_add(simd_float a, simd_float b) { return _mm_add_ps(a, b); }
+static inline simd_float simd_sub(simd_float a, simd_float b) { return _mm_sub_ps(a, b); }
+static inline simd_float simd_mul(simd_float a, simd_float b) { return _mm_mul_ps(a, b); }
+#if MK_FREEVERB_DENORMAL_MODE == MK_FREEVERB_DENORMALS_CHECK
+static inline simd_float simd_flush_denormals(simd_float v)
+{
+	const __m128 expmask = _mm_castsi128_ps(_mm_set1_epi32(0x7f800000));
+	return _mm_and_ps(v, _mm_cmpneq_ps(_mm_and_ps(v, expmask), _mm_setzero_ps()));
+}
+#endif
+#elif MK_FREEVERB_SIMD_NEON
+typedef float32x4_t simd_float;
+static inline simd_float simd_load(const float *p) { return vld1q_f32(p); }
+static inline void simd_store(float *p, simd_float v) { vst1q_f32(p, v); }
+static inline simd_float simd_loadu(const float *p) { return vld1q_f32(p); }
+static inline void simd_storeu(float *p, simd_float v) { vst1q_f32(p, v); }
+static inline simd_float simd_set1(float v) { return vdupq_n_f32(v); }
+static inline simd_float simd_add(simd_float a, simd_float b) { return vaddq_f32(a, b); }
+static inline simd_float simd_sub(simd_float a, simd_float b) { return vsubq_f32(a, b); }
+static inline simd_float simd_mul(simd_float a, simd_float b) { return vmulq_f32(a, b); }
+#if MK_FREEVERB_DENORMAL_MODE == MK_FREEVERB_DENORMALS_CHECK
+static inline simd_float simd_flush_denormals(simd_float v)
+{
+	uint32x4_t bits = vreinterpretq_u32_f32(v);
+	return vreinterpretq_f32_u32(vandq_u32(bits, vtstq_u32(bits, vdupq_n_u32(0x7f800000))));
+}
+#endif
+#else
+struct simd_float { float v[MK_FREEVERB_SIMD_WIDTH]; };
+static inline simd_float simd_load(const float *p)
+{
+	simd_float r;
+	for (int i=0; i<MK_FREEVERB_SIMD_WIDTH; i++) r.v[i] = p[i];
+	return r;
+}
+static inline void simd_store(float *p, simd_float v)
+{
+	for (int i=0; i<MK_FREEVERB_SIMD_WIDTH; i++) p[i] = v.v[i];
+}
+static inline simd_float simd_loadu(const float *p) { return simd_load(p); }
+static inline void simd_storeu(float *p, simd_float v) { simd_store(p, v); }
+static inline simd_float simd_set1(float v)
+{
+	simd_float r;
+	for (int i=0; i<MK_FREEVERB_SIMD_WIDTH; i++) r.v[i] = v;
+	return r;
+}
+static inline simd_float simd_add(simd_float a, simd_float b)
+{
+	for (int i=0; i<MK_FREEVERB_SIMD_WIDTH; i++) a.v[i] = a.v[i] + b.v[i];
+	return a;
+}
+static inline simd_float simd_sub(simd_float a, simd_float b)
+{
+	for (int i=0; i<MK_FREEVERB_SIMD_WIDTH; i++) a.v[i] = a.v[i] - b.v[i];
+	return a;
+}
+static inline simd_float simd_mul(simd_float a, simd_float b)
+{
+	for (int i=0; i<MK_FREEVERB_SIMD_WIDTH; i++) a.v[i] = a.v[i] * b.v[i];
+	return a;
+}
+#if MK_FREEVERB_DENORMAL_MODE == MK_FREEVERB_DENORMALS_CHECK
+static inline simd_float simd_flush_denormals(simd_float v)
+{
+	for (int i=0; i<MK_FREEVERB_SIMD_WIDTH; i++)
+	{
+		unsigned int bits;
+		memcpy(&bits, &v.v[i], sizeof(bits));
+		v.v[i] = (bits&0x7f800000) ? v.v[i] : 0.0f;
+	}
+	return v;
+}
+#endif
+#endif
+
+#if MK_FREEVERB_DENORMAL_MODE != MK_FREEVERB_DENORMALS_CHECK
+static inline simd_float simd_undenormalise(simd_float v) { return v; }
+#elif MK_FREEVERB_ENABLE_STATS && defined(__cplusplus)
+static inline simd_float simd_undenormalise(simd_float v)
+{
+	// Counts the lanes about to be flushed for mk_freeverb_stats
+	alignas(32) float lanes[MK_FREEVERB_SIMD_WIDTH];
+	simd_store(lanes, v);
+	for (int i=0; i<MK_FREEVERB_SIMD_WIDTH; i++) mk_freeverb_count_denormal(lanes[i]);
+	return simd_flush_denormals(v);
+}
+#else
+static inline simd_float simd_undenormalise(simd_float v) { return simd_flush_denormals(v); }
+#endif
+
+#endif//_mk_freeverb_simd_
+
+//ends
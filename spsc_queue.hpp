@@ -0,0 +1,71 @@
+#ifndef MK_FREEVERB_SPSC_QUEUE_HPP
+#define MK_FREEVERB_SPSC_QUEUE_HPP
+
+#include <atomic>
+#include <cstdint>
+
+// Lock-free single-producer/single-consumer ring of trivially copyable items
+// One thread (e.g. control/MIDI) pushes, one thread (audio) pops.
+// Both sides are wait-free; nothing blocks or allocates. Items pushed
+// together form a batch that pop() hands out whole.
+template <typename T, int Capacity>
+class spsc_queue
+{
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+    // Producer side: publish all items or none (returns false when full).
+    // The consumer never sees a partially written batch.
+    bool push(const T *items, int count) {
+        const uint32_t tail = tail_.load(std::memory_order_relaxed);
+        const uint32_t head = head_.load(std::memory_order_acquire);
+        if (count < 0 || static_cast<uint32_t>(count) > Capacity - (tail - head)) {
+            return false;
+        }
+
+        for (int i = 0; i < count; i++) {
+            slots_[(tail + i) & (Capacity - 1)] = items[i];
+            batchEnd_[(tail + i) & (Capacity - 1)] = i == count - 1;
+        }
+        tail_.store(tail + count, std::memory_order_release);
+        return true;
+    }
+
+    bool push(const T &item) {
+        return push(&item, 1);
+    }
+
+    // Consumer side: pop up to maxItems in push order, returns the count.
+    // A batch is never split: when maxItems ends inside one, the pop stops
+    // before it, unless that batch alone is larger than maxItems
+    int pop(T *items, int maxItems) {
+        const uint32_t head = head_.load(std::memory_order_relaxed);
+        const uint32_t tail = tail_.load(std::memory_order_acquire);
+        uint32_t count = tail - head;
+        if (maxItems < 0) maxItems = 0;
+        if (count > static_cast<uint32_t>(maxItems)) {
+            count = maxItems;
+            uint32_t whole = count;
+            while (whole > 0 && !batchEnd_[(head + whole - 1) & (Capacity - 1)]) {
+                whole--;
+            }
+            if (whole > 0) count = whole;
+        }
+
+        for (uint32_t i = 0; i < count; i++) {
+            items[i] = slots_[(head + i) & (Capacity - 1)];
+        }
+        head_.store(head + count, std::memory_order_release);
+        return static_cast<int>(count);
+    }
+
+private:
+    T slots_[Capacity];
+    bool batchEnd_[Capacity] = {};     // slot holds the last item of its batch
+
+    // Free-running indices on separate cache lines
+    alignas(64) std::atomic<uint32_t> head_{0};
+    alignas(64) std::atomic<uint32_t> tail_{0};
+};
+
+#endif // MK_FREEVERB_SPSC_QUEUE_HPP
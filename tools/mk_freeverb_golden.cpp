@@ -0,0 +1,762 @@
+// Golden-output regression check: renders fixed test signals through every
+// preset and a matrix of configurations and compares them with the
+// committed references in tools/mk_freeverb_golden.ref, plus a throughput
+// floor per configuration.
+//
+// Usage: mk_freeverb_golden --check=FILE [--renders=DIR] [options]
+//        mk_freeverb_golden --write=FILE [options]
+//        mk_freeverb_golden --dump=DIR [options]
+//   --combs=1,...,8         comb counts (default all eight)
+//   --features=0,1,3,4,5,7  ReverbFeatures masks (default all six distinct sets)
+//   --min-snr=DB            accept any build at this SNR instead of the table below
+//   --max-slowdown=PCT      allowed throughput loss against the reference (default 25)
+//   --no-perf               skip the throughput check
+//   -v, --verbose           one line per case
+//
+// Each case is one preset from ReverbPresets::ALL_PRESETS and one signal
+// (an impulse, a logarithmic sine sweep, white noise, and a late impulse
+// through a small room behind 90 ms of predelay) rendered through a
+// fresh make_mk_freeverb(combs, features) instance at 48 kHz, in irregular
+// process_block() sizes, for every comb count and feature set
+// make_mk_freeverb builds. --write stores one line per case with an FNV-1a
+// hash of the float32 output and its energy per quarter and channel in dB,
+// the build it came from, and the throughput of the 4 and 8 comb
+// configurations. --check renders the same cases and fails on a missing
+// file or case. A build with the arithmetic of the references (delay
+// storage, denormal mode and block size) has to reproduce every hash on
+// the platform (architecture and compiler major version) that wrote them,
+// and elsewhere every quarter within 40 dB of the loudest to within
+// 1 dB. The throughput reference is the median of three measurements. A
+// build that changes the arithmetic is compared with --renders, the
+// full float32 output that --dump wrote from a build that passed:
+//
+//   renders and current build        requirement
+//   other denormal mode              SNR >= 120 dB
+//   other MK_FREEVERB_BLOCK_SIZE     SNR >= 65 dB (predelay case 35 dB)
+//   fp16 lines (either side)         SNR >= 60 dB
+//   int16 lines, sweep and noise     SNR >= 40 dB
+//   int16 lines, impulses            SNR >= 14 dB
+//
+// The SIMD backend and comb bank never change the output, so they are
+// required to be bit-exact. The block size only moves the point where a
+// decayed tail goes to sleep, which leaves differences near -100 dBFS;
+// the fewer combs, the less energy the tail holds against them (worst
+// 69.5 dB with one comb), and the small room of the predelay case weighs
+// in at 40.2 dB (two combs). int16 lines hold a decaying tail only down to their
+// 2^-14 step, so the impulse cases, whose tails carry most of their
+// energy, get a floor of their own (worst 15.0 dB, one comb); the sweep
+// and noise stay far above the step (worst 41.2 dB). SNR counts the
+// renders as signal and the difference as noise over both channels of a
+// case.
+//
+// Throughput is the best of five renders of five seconds of noise through
+// Medium Hall in 256-sample blocks, after one warm-up render. Each render
+// is followed by a fixed scalar loop over the same number of samples, and
+// the check compares the ratio of the two, which follows clock and load
+// changes of the machine far less than the raw ns/sample. A configuration
+// fails when its ratio is more than --max-slowdown percent above the
+// reference, which is still only meaningful on a machine and compiler
+// like the one that wrote it. Only 4 and 8 combs are timed: the other
+// counts run the same kernels over fewer or more lines, and five renders
+// of each would more than double the run.
+//
+// Exits with 0 when every case passes, 1 on a failure and 2 on usage or
+// file errors. tools/run_golden.sh runs it over a set of build macros.
+
+#include "mk_freeverb.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+
+const float sampleRate = 48000.0f;
+
+enum { Impulse, Sweep, Noise, PredelayImpulse, NumSignals };
+const char *signalNames[NumSignals] = { "impulse", "sweep", "noise", "predelay" };
+const int signalFrames[NumSignals] = { 24000, 24000, 12000, 24000 };
+
+struct Signal
+{
+    std::vector<float> left, right;
+};
+
+Signal test_signal(int type)
+{
+    const int frames = signalFrames[type];
+    Signal s;
+    s.left.assign(frames, 0.0f);
+    s.right.assign(frames, 0.0f);
+
+    if (type == Impulse)
+    {
+        s.left[0] = 1.0f;
+        s.right[100] = -0.5f;
+    }
+    else if (type == PredelayImpulse)
+    {
+        // Late enough that the input is quiet for a while before it
+        s.left[5000] = 1.0f;
+        s.right[5100] = -0.5f;
+    }
+    else if (type == Sweep)
+    {
+        // 20 Hz to 20 kHz, the right channel a quarter period ahead
+        double phase = 0;
+        for (int i = 0; i < frames; i++)
+        {
+            const double f = 20.0 * std::pow(1000.0, static_cast<double>(i) / frames);
+            phase += 2 * M_PI * f / sampleRate;
+            s.left[i] = 0.5f * static_cast<float>(std::sin(phase));
+            s.right[i] = 0.5f * static_cast<float>(std::cos(phase));
+        }
+    }
+    else
+    {
+        unsigned seed = 12345;
+        for (int i = 0; i < frames; i++)
+        {
+            seed = seed * 1664525u + 1013904223u;
+            s.left[i] = 0.5f * (((seed >> 8) / 16777216.0f) * 2.0f - 1.0f);
+            seed = seed * 1664525u + 1013904223u;
+            s.right[i] = 0.5f * (((seed >> 8) / 16777216.0f) * 2.0f - 1.0f);
+        }
+    }
+    return s;
+}
+
+// Output of one case, left then right
+std::vector<float> render(int combs, unsigned features, int preset, int type, const Signal& in)
+{
+    std::unique_ptr<mk_freeverb_processor> reverb = make_mk_freeverb(combs, features, sampleRate);
+    reverb->process_block(nullptr, nullptr, nullptr, nullptr, 0);   // apply the queued default preset
+    reverb->apply_preset(*ReverbPresets::ALL_PRESETS[preset]);
+    if (type == PredelayImpulse)
+    {
+        // A short tail behind a predelay longer than its sleep hold
+        reverb->setRoomSize(0.1f);
+        reverb->setPredelay(0.09f);
+    }
+
+    const int frames = static_cast<int>(in.left.size());
+    std::vector<float> out(2 * frames);
+    const int sizes[] = { 64, 1, 17, 256, 300, 128, 1000 };
+    for (int pos = 0, k = 0; pos < frames; k++)
+    {
+        const int n = std::min(sizes[k % 7], frames - pos);
+        reverb->process_block(&in.left[pos], &in.right[pos], &out[pos], &out[frames + pos], n);
+        pos += n;
+    }
+    return out;
+}
+
+// Fixed scalar workload timed next to every throughput run: a stereo
+// two-pole recursion, dependent on each previous sample like a comb
+float calibration_pass(const Signal& noise, int total)
+{
+    const int frames = static_cast<int>(noise.left.size());
+    float l1 = 0, l2 = 0, r1 = 0, r2 = 0;
+    for (int done = 0; done < total; done++)
+    {
+        const int pos = done % frames;
+        const float l = noise.left[pos] + 1.6f * l1 - 0.64f * l2;
+        const float r = noise.right[pos] + 1.6f * r1 - 0.64f * r2;
+        l2 = l1; l1 = l;
+        r2 = r1; r1 = r;
+    }
+    return l1 + r1;
+}
+
+struct Throughput
+{
+    double ns;          // per sample
+    double relative;    // ns over calibration ns
+};
+
+Throughput measure_throughput(int combs, unsigned features, const Signal& noise)
+{
+    std::unique_ptr<mk_freeverb_processor> reverb = make_mk_freeverb(combs, features, sampleRate);
+    reverb->process_block(nullptr, nullptr, nullptr, nullptr, 0);
+    reverb->apply_preset(ReverbPresets::MEDIUM_HALL);
+
+    const int block = 256;
+    const int frames = static_cast<int>(noise.left.size()) / block * block;
+    const int total = 5 * static_cast<int>(sampleRate);
+    std::vector<float> outL(block), outR(block);
+
+    double best = 0, bestCalibration = 0;
+    volatile float sink = 0;
+    for (int run = 0; run < 6; run++)
+    {
+        auto t0 = std::chrono::steady_clock::now();
+        for (int done = 0; done < total; done += block)
+        {
+            const int pos = done % frames;
+            reverb->process_block(&noise.left[pos], &noise.right[pos], outL.data(), outR.data(), block);
+        }
+        auto t1 = std::chrono::steady_clock::now();
+        sink = calibration_pass(noise, total);
+        auto t2 = std::chrono::steady_clock::now();
+
+        const double ns = std::chrono::duration<double, std::nano>(t1 - t0).count() / total;
+        const double calibration = std::chrono::duration<double, std::nano>(t2 - t1).count() / total;
+        if (run == 0) continue;     // warm-up
+        if (best == 0 || ns < best) best = ns;
+        if (bestCalibration == 0 || calibration < bestCalibration) bestCalibration = calibration;
+    }
+    (void)sink;
+    return { best, best / bestCalibration };
+}
+
+double snr_db(const std::vector<float>& reference, const std::vector<float>& test)
+{
+    double signal = 0, noise = 0;
+    for (size_t i = 0; i < reference.size(); i++)
+    {
+        const double d = static_cast<double>(test[i]) - reference[i];
+        signal += static_cast<double>(reference[i]) * reference[i];
+        noise += d * d;
+    }
+    if (noise == 0) return INFINITY;
+    if (signal == 0) return -INFINITY;
+    return 10 * std::log10(signal / noise);
+}
+
+const char *delay_storage_name()
+{
+#if MK_FREEVERB_DELAY_STORAGE == MK_FREEVERB_DELAY_INT16
+    return "int16";
+#elif MK_FREEVERB_DELAY_STORAGE == MK_FREEVERB_DELAY_FP16
+    return "fp16";
+#else
+    return "float";
+#endif
+}
+
+const char *denormal_mode_name()
+{
+#if MK_FREEVERB_DENORMAL_MODE == MK_FREEVERB_DENORMALS_CHECK
+    return "check";
+#elif MK_FREEVERB_DENORMAL_MODE == MK_FREEVERB_DENORMALS_OFFSET
+    return "offset";
+#else
+    return "ftz";
+#endif
+}
+
+// Minimum SNR for comparing against a reference build, INFINITY for bit-exact
+double required_snr(const std::string& storage, const std::string& denormals, int block, int signal)
+{
+    const std::string current = delay_storage_name();
+    if (storage == "int16" || current == "int16") return signal == Impulse || signal == PredelayImpulse ? 14 : 40;
+    if (storage == "fp16" || current == "fp16") return 60;
+    if (block != MK_FREEVERB_BLOCK_SIZE) return signal == PredelayImpulse ? 35 : 65;
+    if (denormals != denormal_mode_name()) return 120;
+    return INFINITY;
+}
+
+// Platform tag stored with the references: bit-exactness is only expected
+// from the architecture and compiler that wrote them
+std::string platform_name()
+{
+#if defined(__x86_64__) || defined(_M_X64)
+    std::string arch = "x86_64";
+#elif defined(__aarch64__) || defined(_M_ARM64)
+    std::string arch = "aarch64";
+#elif defined(__arm__)
+    std::string arch = "arm";
+#else
+    std::string arch = "other";
+#endif
+    char compiler[32];
+#if defined(__clang__)
+    snprintf(compiler, sizeof(compiler), "-clang%d", __clang_major__);
+#elif defined(__GNUC__)
+    snprintf(compiler, sizeof(compiler), "-gcc%d", __GNUC__);
+#elif defined(_MSC_VER)
+    snprintf(compiler, sizeof(compiler), "-msvc%d", _MSC_VER);
+#else
+    snprintf(compiler, sizeof(compiler), "-unknown");
+#endif
+    return arch + compiler;
+}
+
+// Committed summary of one case: a hash of the output and its energy per
+// quarter of the render, left quarters then right, in dB
+enum { Quarters = 4, FingerprintSize = 2 * Quarters };
+const double fingerprintTolerance = 1.0;   // dB, quarters within fingerprintRange of the loudest
+const double fingerprintRange = 40.0;
+
+struct Summary
+{
+    uint64_t hash = 0;
+    double energy[FingerprintSize] = {};
+};
+
+Summary summarize(const std::vector<float>& out)
+{
+    Summary summary;
+    uint64_t hash = 14695981039346656037ull;     // FNV-1a
+    const unsigned char *bytes = reinterpret_cast<const unsigned char *>(out.data());
+    for (size_t i = 0; i < out.size() * sizeof(float); i++)
+        hash = (hash ^ bytes[i]) * 1099511628211ull;
+    summary.hash = hash;
+
+    const size_t frames = out.size() / 2;
+    for (int q = 0; q < FingerprintSize; q++)
+    {
+        const size_t begin = (q / Quarters) * frames + (q % Quarters) * frames / Quarters;
+        const size_t end = (q / Quarters) * frames + (q % Quarters + 1) * frames / Quarters;
+        double sum = 0;
+        for (size_t i = begin; i < end; i++)
+            sum += static_cast<double>(out[i]) * out[i];
+        summary.energy[q] = sum > 0 ? std::max(10 * std::log10(sum / (end - begin)), -200.0) : -200.0;
+    }
+    return summary;
+}
+
+// Largest difference over the quarters that are within fingerprintRange
+// of the loudest reference quarter
+double fingerprint_difference(const Summary& reference, const Summary& current)
+{
+    const double loudest = *std::max_element(reference.energy, reference.energy + FingerprintSize);
+    double worst = 0;
+    for (int q = 0; q < FingerprintSize; q++)
+    {
+        if (std::max(reference.energy[q], current.energy[q]) < loudest - fingerprintRange) continue;
+        worst = std::max(worst, std::fabs(reference.energy[q] - current.energy[q]));
+    }
+    return worst;
+}
+
+int case_key(int combs, int features, int preset, int signal)
+{
+    return ((combs * 8 + features) * ReverbPresets::NUM_PRESETS + preset) * NumSignals + signal;
+}
+
+// Throughput is only tracked at these comb counts: the others run the
+// same kernels over fewer or more lines and scale in between
+const int perfCombs[] = { 4, 8 };
+
+struct Options
+{
+    std::string reference;  // compact reference file
+    std::string renders;    // full renders to measure SNR against
+    enum { Check, Write, Dump } mode = Check;
+    std::vector<int> combs = { 1, 2, 3, 4, 5, 6, 7, 8 };
+    std::vector<int> features = { 0, 1, 3, 4, 5, 7 };
+    double minSnr = NAN;
+    double maxSlowdown = 25;
+    bool perf = true;
+    bool verbose = false;
+};
+
+std::vector<int> parse_list(const char *s)
+{
+    std::vector<int> values;
+    while (*s)
+    {
+        char *end;
+        long v = strtol(s, &end, 10);
+        if (end == s) break;
+        values.push_back(static_cast<int>(v));
+        s = *end == ',' ? end + 1 : end;
+    }
+    return values;
+}
+
+std::string file_name(int combs, int features)
+{
+    char name[64];
+    snprintf(name, sizeof(name), "combs%d_features%d.f32", combs, features);
+    return name;
+}
+
+size_t frames_per_config()
+{
+    size_t frames = 0;
+    for (int s = 0; s < NumSignals; s++)
+        frames += signalFrames[s];
+    return frames * ReverbPresets::NUM_PRESETS;
+}
+
+bool tracks_throughput(const Options& opt, int combs)
+{
+    return opt.perf && std::count(std::begin(perfCombs), std::end(perfCombs), combs) > 0;
+}
+
+int write_references(const Options& opt, const Signal *signals)
+{
+    FILE *f = fopen(opt.reference.c_str(), "w");
+    if (!f)
+    {
+        fprintf(stderr, "cannot write %s\n", opt.reference.c_str());
+        return 2;
+    }
+    fprintf(f, "mk_freeverb golden 3\n");
+    fprintf(f, "build storage=%s denormals=%s block=%d platform=%s\n", delay_storage_name(), denormal_mode_name(),
+            MK_FREEVERB_BLOCK_SIZE, platform_name().c_str());
+
+    for (int combs : opt.combs)
+    {
+        for (int features : opt.features)
+        {
+            for (int p = 0; p < ReverbPresets::NUM_PRESETS; p++)
+            {
+                for (int s = 0; s < NumSignals; s++)
+                {
+                    const Summary summary = summarize(render(combs, features, p, s, signals[s]));
+                    fprintf(f, "case combs=%d features=%d preset=%d signal=%d hash=%016llx energy=", combs, features, p, s,
+                            static_cast<unsigned long long>(summary.hash));
+                    for (int q = 0; q < FingerprintSize; q++)
+                        fprintf(f, q ? ",%.1f" : "%.1f", summary.energy[q]);
+                    fprintf(f, "\n");
+                }
+            }
+
+            if (tracks_throughput(opt, combs))
+            {
+                // Median of three measurements, so one disturbed run does
+                // not set the reference
+                Throughput runs[3];
+                for (Throughput& run : runs)
+                    run = measure_throughput(combs, features, signals[Noise]);
+                std::sort(std::begin(runs), std::end(runs),
+                          [](const Throughput& a, const Throughput& b) { return a.relative < b.relative; });
+                const Throughput& t = runs[1];
+                fprintf(f, "perf combs=%d features=%d relative=%.4f\n", combs, features, t.relative);
+                printf("combs %d features %d written, %.2f ns/sample (%.2fx calibration)\n", combs, features, t.ns, t.relative);
+            }
+            else
+            {
+                printf("combs %d features %d written\n", combs, features);
+            }
+        }
+    }
+    fclose(f);
+    return 0;
+}
+
+// Full float32 renders of this build, for checking builds with other
+// arithmetic by SNR
+int dump_renders(const Options& opt, const Signal *signals)
+{
+    const std::string indexPath = opt.renders + "/index.txt";
+    FILE *index = fopen(indexPath.c_str(), "w");
+    if (!index)
+    {
+        fprintf(stderr, "cannot write %s\n", indexPath.c_str());
+        return 2;
+    }
+    fprintf(index, "mk_freeverb renders 1\n");
+    fprintf(index, "build storage=%s denormals=%s block=%d\n", delay_storage_name(), denormal_mode_name(), MK_FREEVERB_BLOCK_SIZE);
+    fclose(index);
+
+    for (int combs : opt.combs)
+    {
+        for (int features : opt.features)
+        {
+            const std::string path = opt.renders + "/" + file_name(combs, features);
+            FILE *f = fopen(path.c_str(), "wb");
+            if (!f)
+            {
+                fprintf(stderr, "cannot write %s\n", path.c_str());
+                return 2;
+            }
+            for (int p = 0; p < ReverbPresets::NUM_PRESETS; p++)
+            {
+                for (int s = 0; s < NumSignals; s++)
+                {
+                    const std::vector<float> out = render(combs, features, p, s, signals[s]);
+                    fwrite(out.data(), sizeof(float), out.size(), f);
+                }
+            }
+            fclose(f);
+        }
+    }
+    return 0;
+}
+
+int check_references(const Options& opt, const Signal *signals)
+{
+    FILE *f = fopen(opt.reference.c_str(), "r");
+    char storage[16] = "", denormals[16] = "", platform[64] = "";
+    int block = 0;
+    if (!f || fscanf(f, "mk_freeverb golden 3 build storage=%15s denormals=%15s block=%d platform=%63s",
+                     storage, denormals, &block, platform) != 4)
+    {
+        fprintf(stderr, "cannot read references from %s\n", opt.reference.c_str());
+        if (f) fclose(f);
+        return 2;
+    }
+
+    std::map<int, Summary> cases;
+    std::map<int, double> perfReference;
+    char kind[8];
+    while (fscanf(f, " %7s", kind) == 1)
+    {
+        int combs, features, preset, signal;
+        if (!strcmp(kind, "case"))
+        {
+            Summary summary;
+            unsigned long long hash;
+            if (fscanf(f, " combs=%d features=%d preset=%d signal=%d hash=%llx energy=", &combs, &features, &preset, &signal, &hash) != 5)
+                break;
+            summary.hash = hash;
+            for (int q = 0; q < FingerprintSize; q++)
+                if (fscanf(f, q ? ",%lf" : "%lf", &summary.energy[q]) != 1) break;
+            cases[case_key(combs, features, preset, signal)] = summary;
+        }
+        else if (!strcmp(kind, "perf"))
+        {
+            double relative;
+            if (fscanf(f, " combs=%d features=%d relative=%lf", &combs, &features, &relative) != 3) break;
+            perfReference[combs * 8 + features] = relative;
+        }
+        else
+        {
+            break;
+        }
+    }
+    const bool complete = feof(f);
+    fclose(f);
+    if (!complete)
+    {
+        fprintf(stderr, "malformed references in %s\n", opt.reference.c_str());
+        return 2;
+    }
+
+    // Same arithmetic and platform as the references: every case bit-exact.
+    // Same arithmetic elsewhere: the energy fingerprint within
+    // fingerprintTolerance. Other arithmetic: the SNR table against
+    // --renders of a build that passed the references
+    const bool sameArithmetic = storage == std::string(delay_storage_name()) &&
+                                denormals == std::string(denormal_mode_name()) && block == MK_FREEVERB_BLOCK_SIZE;
+    const bool samePlatform = platform == platform_name();
+    printf("reference: %s lines, %s denormals, block %d, %s; this build: %s lines, %s denormals, block %d, %s\n",
+           storage, denormals, block, platform, delay_storage_name(), denormal_mode_name(), MK_FREEVERB_BLOCK_SIZE,
+           platform_name().c_str());
+
+    // Renders to measure SNR against, and the requirement their build sets
+    double required[NumSignals];
+    bool haveRenders = !opt.renders.empty();
+    if (!sameArithmetic && !haveRenders)
+    {
+        fprintf(stderr, "this build changes the arithmetic of the references, check it with --renders=DIR\n");
+        return 2;
+    }
+    if (haveRenders)
+    {
+        const std::string indexPath = opt.renders + "/index.txt";
+        FILE *index = fopen(indexPath.c_str(), "r");
+        char rstorage[16] = "", rdenormals[16] = "";
+        int rblock = 0;
+        if (!index || fscanf(index, "mk_freeverb renders 1 build storage=%15s denormals=%15s block=%d", rstorage, rdenormals, &rblock) != 3)
+        {
+            fprintf(stderr, "cannot read %s\n", indexPath.c_str());
+            if (index) fclose(index);
+            return 2;
+        }
+        fclose(index);
+        for (int s = 0; s < NumSignals; s++)
+            required[s] = std::isnan(opt.minSnr) ? required_snr(rstorage, rdenormals, rblock, s) : opt.minSnr;
+    }
+
+    printf("requirement:");
+    if (sameArithmetic)
+    {
+        if (samePlatform) printf(" bit-exact");
+        else printf(" fingerprint within %.1f dB", fingerprintTolerance);
+    }
+    // One figure when every signal has the same requirement
+    const bool uniform = std::count(required, required + NumSignals, required[0]) == NumSignals;
+    for (int s = 0; haveRenders && s < (uniform ? 1 : NumSignals); s++)
+    {
+        printf("%s%s%s", s || sameArithmetic ? "," : "", uniform ? "" : " ", uniform ? "" : signalNames[s]);
+        if (std::isinf(required[s])) printf(" bit-exact with the renders");
+        else printf(" SNR >= %.0f dB", required[s]);
+    }
+    printf("\n");
+
+    int failures = 0;
+    for (int combs : opt.combs)
+    {
+        for (int features : opt.features)
+        {
+            const std::string name = file_name(combs, features);
+            std::vector<float> renders;
+            if (haveRenders)
+            {
+                const std::string path = opt.renders + "/" + name;
+                FILE *rf = fopen(path.c_str(), "rb");
+                renders.resize(2 * frames_per_config());
+                if (!rf || fread(renders.data(), sizeof(float), renders.size(), rf) != renders.size())
+                {
+                    fprintf(stderr, "cannot read %s\n", path.c_str());
+                    if (rf) fclose(rf);
+                    return 2;
+                }
+                fclose(rf);
+            }
+
+            int configFailures = 0, exactCases = 0, cases_ = 0;
+            double worstSnr = INFINITY, worstFingerprint = 0;
+            size_t offset = 0;
+            for (int p = 0; p < ReverbPresets::NUM_PRESETS; p++)
+            {
+                for (int s = 0; s < NumSignals; s++)
+                {
+                    const std::vector<float> out = render(combs, features, p, s, signals[s]);
+                    const Summary current = summarize(out);
+                    cases_++;
+
+                    auto it = cases.find(case_key(combs, features, p, s));
+                    std::string result;
+                    bool ok = true;
+                    if (it == cases.end())
+                    {
+                        ok = false;
+                        result = "no reference";
+                    }
+                    else if (it->second.hash == current.hash)
+                    {
+                        exactCases++;
+                        result = "bit-exact";
+                    }
+                    else if (sameArithmetic)
+                    {
+                        const double fingerprint = fingerprint_difference(it->second, current);
+                        worstFingerprint = std::max(worstFingerprint, fingerprint);
+                        ok = !samePlatform && fingerprint <= fingerprintTolerance;
+                        char text[64];
+                        snprintf(text, sizeof(text), "fingerprint %.2f dB", fingerprint);
+                        result = text;
+                    }
+                    else
+                    {
+                        result = "differs";
+                    }
+
+                    if (haveRenders)
+                    {
+                        const std::vector<float> expected(renders.begin() + offset, renders.begin() + offset + out.size());
+                        const bool exact = !memcmp(out.data(), expected.data(), out.size() * sizeof(float));
+                        const double snr = exact ? INFINITY : snr_db(expected, out);
+                        worstSnr = std::min(worstSnr, snr);
+                        ok = ok && (exact || snr >= required[s]);
+                        char text[64];
+                        snprintf(text, sizeof(text), exact ? ", renders bit-exact" : ", SNR %.1f dB", snr);
+                        result += text;
+                    }
+                    offset += out.size();
+
+                    if (!ok) configFailures++;
+                    if (!ok || opt.verbose)
+                        printf("  %s %-16s %-8s %s%s\n", name.c_str(), ReverbPresets::PRESET_NAMES[p], signalNames[s],
+                               result.c_str(), ok ? "" : "  FAIL");
+                }
+            }
+
+            std::string summary;
+            char text[160];
+            if (exactCases == cases_)
+            {
+                summary = "bit-exact";
+            }
+            else if (sameArithmetic)
+            {
+                snprintf(text, sizeof(text), "%d/%d bit-exact, fingerprint within %.2f dB", exactCases, cases_, worstFingerprint);
+                summary = text;
+            }
+            else
+            {
+                snprintf(text, sizeof(text), "%d/%d bit-exact", exactCases, cases_);
+                summary = text;
+            }
+            if (haveRenders && !std::isinf(worstSnr))
+            {
+                snprintf(text, sizeof(text), ", worst %.1f dB", worstSnr);
+                summary += text;
+            }
+
+            if (tracks_throughput(opt, combs))
+            {
+                auto ref = perfReference.find(combs * 8 + features);
+                if (ref == perfReference.end())
+                {
+                    summary += ", no throughput reference  FAIL";
+                    configFailures++;
+                }
+                else
+                {
+                    const Throughput t = measure_throughput(combs, features, signals[Noise]);
+                    const bool ok = t.relative <= ref->second * (1 + opt.maxSlowdown / 100);
+                    snprintf(text, sizeof(text), ", %.2f ns/sample, %.2fx calibration (reference %.2fx)%s",
+                             t.ns, t.relative, ref->second, ok ? "" : "  SLOW");
+                    summary += text;
+                    if (!ok) configFailures++;
+                }
+            }
+
+            printf("%-24s %s\n", name.c_str(), summary.c_str());
+            failures += configFailures;
+        }
+    }
+
+    if (failures)
+        printf("%d failure(s)\n", failures);
+    return failures ? 1 : 0;
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    Options opt;
+    bool usage = false;
+    for (int i = 1; i < argc; i++)
+    {
+        const char *a = argv[i];
+        if (!strncmp(a, "--write=", 8)) { opt.reference = a + 8; opt.mode = Options::Write; }
+        else if (!strncmp(a, "--check=", 8)) { opt.reference = a + 8; opt.mode = Options::Check; }
+        else if (!strncmp(a, "--dump=", 7)) { opt.renders = a + 7; opt.mode = Options::Dump; }
+        else if (!strncmp(a, "--renders=", 10)) opt.renders = a + 10;
+        else if (!strncmp(a, "--combs=", 8)) opt.combs = parse_list(a + 8);
+        else if (!strncmp(a, "--features=", 11)) opt.features = parse_list(a + 11);
+        else if (!strncmp(a, "--min-snr=", 10)) opt.minSnr = atof(a + 10);
+        else if (!strncmp(a, "--max-slowdown=", 15)) opt.maxSlowdown = atof(a + 15);
+        else if (!strcmp(a, "--no-perf")) opt.perf = false;
+        else if (!strcmp(a, "-v") || !strcmp(a, "--verbose")) opt.verbose = true;
+        else usage = true;
+    }
+    for (int combs : opt.combs)
+        usage |= combs < 1 || combs > numcombs;
+    for (int features : opt.features)
+        usage |= features < 0 || features > static_cast<int>(ReverbFeatures::All);
+    usage |= opt.mode == Options::Dump ? opt.renders.empty() : opt.reference.empty();
+    if (usage)
+    {
+        fprintf(stderr, "usage: %s --check=FILE [--renders=DIR] | --write=FILE | --dump=DIR\n"
+                        "       [--combs=1,...,8] [--features=0,1,3,4,5,7] [--min-snr=DB] [--max-slowdown=PCT]"
+                        " [--no-perf] [-v]\n", argv[0]);
+        return 2;
+    }
+
+    Signal signals[NumSignals];
+    for (int s = 0; s < NumSignals; s++)
+        signals[s] = test_signal(s);
+
+    if (opt.mode == Options::Write) return write_references(opt, signals);
+    if (opt.mode == Options::Dump) return dump_renders(opt, signals);
+    return check_references(opt, signals);
+}
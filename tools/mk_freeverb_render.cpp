@@ -0,0 +1,766 @@
+// Offline renderer: bakes mk_freeverb into WAV or raw float files
+//
+// Files are streamed in fixed chunks, so memory use does not depend on file
+// length. After the input ends, silence is fed until the reverb tail falls
+// below a threshold (or a maximum length is reached). A directory is
+// rendered by a pool of worker threads, each with its own reverb engine.
+//
+// Usage: mk_freeverb_render [options] -o <output dir> <file or dir>...
+//   -o, --output=DIR        output directory (required, file names are kept)
+//   -p, --preset=N          index into ReverbPresets::ALL_PRESETS (default 0)
+//   -j, --jobs=N            worker threads (default: hardware threads)
+//   --format=same|16|24|32f output sample format (default same as input)
+//   --tail-threshold=DB     end the tail below this peak level (default -90)
+//   --max-tail=SECONDS      tail length limit (default 30)
+//   --chunk=FRAMES          streaming chunk size (default 4096)
+//   --combs=1-8             comb count (default MK_FREEVERB_NUM_COMBS)
+//   --features=MASK         ReverbFeatures mask (default from the build)
+//   --raw-rate=HZ           sample rate of .raw inputs (default 48000)
+//   --raw-channels=1|2      channels of .raw inputs (default 2)
+//   --mmap                  memory-map stereo .raw files (see below)
+//   --hugepages             with --mmap, ask for transparent hugepages
+//   --pipeline              spread each file over 4 threads (see below)
+//   --list-presets          print the preset indices and exit
+//   -v, --verbose           one line per file
+//
+// WAV input: 16/24-bit PCM or 32-bit float, mono or stereo. Raw input:
+// interleaved little-endian float32. Output is always stereo, since the
+// reverb is; mono input feeds both reverb inputs.
+//
+// With --mmap, stereo .raw files are mapped instead of streamed and
+// processreplace() reads and writes the interleaved samples in place
+// (skip = 2), so no sample is copied on the way. Other files fall back to
+// streaming.
+//
+// With --pipeline, every worker renders through process_pipelined(): the
+// input stage and the left and right reverb chains of a file run on three
+// extra threads, for long files on machines with more cores than files.
+// The output is identical. The pipeline drains at the end of every call,
+// so use it with a large --chunk (or --mmap, which hands over whole files).
+
+#include "mk_freeverb.hpp"
+#include "mk_freeverb_pipeline.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define MK_RENDER_HAVE_MMAP 1
+#else
+#define MK_RENDER_HAVE_MMAP 0
+#endif
+
+namespace fs = std::filesystem;
+
+namespace {
+
+enum class SampleFormat { Same, Int16, Int24, Float32 };
+
+struct Options
+{
+    std::vector<std::string> inputs;
+    std::string outputDir;
+    int preset = 0;
+    int jobs = 0;
+    SampleFormat format = SampleFormat::Same;
+    float tailThreshold = -90.0f;   // dBFS
+    float maxTail = 30.0f;          // seconds
+    int chunk = 4096;
+    int numCombs = MK_FREEVERB_NUM_COMBS;
+    unsigned features = ReverbFeatures::Default;
+    float rawRate = 48000.0f;
+    int rawChannels = 2;
+    bool mmap = false;
+    bool hugepages = false;
+    bool pipeline = false;
+    bool verbose = false;
+};
+
+// Reverb engines are built once per worker for the highest rate we accept
+const float maxFileRate = 192000.0f;
+
+// ---------------------------------------------------------------------------
+// Audio file streams
+
+struct StreamFormat
+{
+    SampleFormat format = SampleFormat::Float32;
+    int channels = 0;
+    float sampleRate = 0;
+};
+
+int bytes_per_sample(SampleFormat format)
+{
+    switch (format)
+    {
+    case SampleFormat::Int16: return 2;
+    case SampleFormat::Int24: return 3;
+    default: return 4;
+    }
+}
+
+uint32_t read_le32(const unsigned char *p) { return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24); }
+uint16_t read_le16(const unsigned char *p) { return (uint16_t)(p[0] | (p[1] << 8)); }
+
+void write_le32(unsigned char *p, uint32_t v)
+{
+    p[0] = (unsigned char)v; p[1] = (unsigned char)(v >> 8);
+    p[2] = (unsigned char)(v >> 16); p[3] = (unsigned char)(v >> 24);
+}
+
+void write_le16(unsigned char *p, uint16_t v)
+{
+    p[0] = (unsigned char)v; p[1] = (unsigned char)(v >> 8);
+}
+
+// Converts packed little-endian samples to float
+void decode(const unsigned char *in, float *out, size_t count, SampleFormat format)
+{
+    switch (format)
+    {
+    case SampleFormat::Int16:
+        for (size_t i = 0; i < count; i++)
+            out[i] = (int16_t)read_le16(in + 2 * i) * (1.0f / 32768.0f);
+        break;
+    case SampleFormat::Int24:
+        for (size_t i = 0; i < count; i++)
+        {
+            const unsigned char *p = in + 3 * i;
+            int32_t v = (int32_t)(((uint32_t)p[0] << 8) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 24)) >> 8;
+            out[i] = v * (1.0f / 8388608.0f);
+        }
+        break;
+    default:
+        for (size_t i = 0; i < count; i++)
+        {
+            uint32_t bits = read_le32(in + 4 * i);
+            memcpy(&out[i], &bits, sizeof(float));
+        }
+        break;
+    }
+}
+
+// Converts float to packed little-endian samples, rounding and clipping integers
+void encode(const float *in, unsigned char *out, size_t count, SampleFormat format)
+{
+    switch (format)
+    {
+    case SampleFormat::Int16:
+        for (size_t i = 0; i < count; i++)
+        {
+            float v = std::round(in[i] * 32768.0f);
+            v = std::min(std::max(v, -32768.0f), 32767.0f);
+            write_le16(out + 2 * i, (uint16_t)(int16_t)v);
+        }
+        break;
+    case SampleFormat::Int24:
+        for (size_t i = 0; i < count; i++)
+        {
+            float v = std::round(in[i] * 8388608.0f);
+            v = std::min(std::max(v, -8388608.0f), 8388607.0f);
+            int32_t s = (int32_t)v;
+            out[3 * i] = (unsigned char)s;
+            out[3 * i + 1] = (unsigned char)(s >> 8);
+            out[3 * i + 2] = (unsigned char)(s >> 16);
+        }
+        break;
+    default:
+        for (size_t i = 0; i < count; i++)
+        {
+            uint32_t bits;
+            memcpy(&bits, &in[i], sizeof(float));
+            write_le32(out + 4 * i, bits);
+        }
+        break;
+    }
+}
+
+class AudioReader
+{
+public:
+    ~AudioReader() { if (file) fclose(file); }
+
+    // WAV (RIFF/WAVE, PCM 16/24 or float 32) or raw interleaved float32
+    bool open(const fs::path& path, const Options& opt, std::string& error)
+    {
+        file = fopen(path.string().c_str(), "rb");
+        if (!file) { error = "cannot open"; return false; }
+
+        if (is_raw(path))
+        {
+            fmt.format = SampleFormat::Float32;
+            fmt.channels = opt.rawChannels;
+            fmt.sampleRate = opt.rawRate;
+            remaining = UINT64_MAX;
+            return true;
+        }
+        return parse_wav(error);
+    }
+
+    const StreamFormat& format() const { return fmt; }
+
+    // Reads up to maxFrames frames as float, returns the frame count
+    size_t read(float *interleaved, size_t maxFrames)
+    {
+        const size_t frameBytes = (size_t)bytes_per_sample(fmt.format) * fmt.channels;
+        size_t want = maxFrames * frameBytes;
+        if (want > remaining) want = (size_t)(remaining / frameBytes * frameBytes);
+        bytes.resize(want);
+        size_t got = want ? fread(bytes.data(), 1, want, file) : 0;
+        got -= got % frameBytes;
+        remaining -= got;
+        decode(bytes.data(), interleaved, got / bytes_per_sample(fmt.format), fmt.format);
+        return got / frameBytes;
+    }
+
+    static bool is_raw(const fs::path& path)
+    {
+        std::string ext = path.extension().string();
+        std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+        return ext == ".raw";
+    }
+
+private:
+    bool parse_wav(std::string& error)
+    {
+        unsigned char header[12];
+        if (fread(header, 1, 12, file) != 12 || memcmp(header, "RIFF", 4) || memcmp(header + 8, "WAVE", 4))
+        {
+            error = "not a RIFF/WAVE file";
+            return false;
+        }
+
+        bool haveFmt = false;
+        unsigned char chunk[8];
+        while (fread(chunk, 1, 8, file) == 8)
+        {
+            const uint32_t size = read_le32(chunk + 4);
+            if (!memcmp(chunk, "fmt ", 4))
+            {
+                unsigned char f[40] = {};
+                const uint32_t n = size < sizeof(f) ? size : sizeof(f);
+                if (fread(f, 1, n, file) != n) break;
+                if (size > n) fseek(file, size - n, SEEK_CUR);
+                if (size & 1) fseek(file, 1, SEEK_CUR);
+
+                uint16_t tag = read_le16(f);
+                const uint16_t channels = read_le16(f + 2);
+                const uint32_t rate = read_le32(f + 4);
+                const uint16_t bits = read_le16(f + 14);
+                if (tag == 0xFFFE && n >= 26) tag = read_le16(f + 24);  // WAVE_FORMAT_EXTENSIBLE subformat
+
+                if (tag == 1 && bits == 16) fmt.format = SampleFormat::Int16;
+                else if (tag == 1 && bits == 24) fmt.format = SampleFormat::Int24;
+                else if (tag == 3 && bits == 32) fmt.format = SampleFormat::Float32;
+                else { error = "unsupported sample format (need 16/24-bit PCM or 32-bit float)"; return false; }
+
+                fmt.channels = channels;
+                fmt.sampleRate = (float)rate;
+                haveFmt = true;
+            }
+            else if (!memcmp(chunk, "data", 4))
+            {
+                if (!haveFmt) { error = "data before fmt chunk"; return false; }
+                remaining = size;
+                return true;
+            }
+            else
+            {
+                fseek(file, size + (size & 1), SEEK_CUR);
+            }
+        }
+        error = "no data chunk";
+        return false;
+    }
+
+    FILE *file = nullptr;
+    StreamFormat fmt;
+    uint64_t remaining = 0;
+    std::vector<unsigned char> bytes;
+};
+
+class AudioWriter
+{
+public:
+    ~AudioWriter() { close(); }
+
+    bool open(const fs::path& path, const StreamFormat& format, bool raw)
+    {
+        fmt = format;
+        isRaw = raw;
+        file = fopen(path.string().c_str(), "wb");
+        if (!file) return false;
+        if (!isRaw)
+        {
+            // Sizes are patched in close()
+            unsigned char header[44] = {};
+            fill_header(header, 0);
+            if (fwrite(header, 1, sizeof(header), file) != sizeof(header)) return false;
+        }
+        return true;
+    }
+
+    bool write(const float *interleaved, size_t frames)
+    {
+        const size_t count = frames * fmt.channels;
+        bytes.resize(count * bytes_per_sample(fmt.format));
+        encode(interleaved, bytes.data(), count, fmt.format);
+        dataBytes += bytes.size();
+        return fwrite(bytes.data(), 1, bytes.size(), file) == bytes.size();
+    }
+
+    bool close()
+    {
+        if (!file) return true;
+        bool ok = true;
+        if (!isRaw)
+        {
+            if (dataBytes & 1) ok = fputc(0, file) != EOF;
+            unsigned char header[44];
+            fill_header(header, dataBytes > UINT32_MAX - 36 ? UINT32_MAX - 36 : (uint32_t)dataBytes);
+            ok = ok && fseek(file, 0, SEEK_SET) == 0 && fwrite(header, 1, sizeof(header), file) == sizeof(header);
+        }
+        ok = fclose(file) == 0 && ok;
+        file = nullptr;
+        return ok;
+    }
+
+private:
+    void fill_header(unsigned char *h, uint32_t dataSize)
+    {
+        const int sampleBytes = bytes_per_sample(fmt.format);
+        memcpy(h, "RIFF", 4);
+        write_le32(h + 4, 36 + dataSize + (dataSize & 1));
+        memcpy(h + 8, "WAVEfmt ", 8);
+        write_le32(h + 16, 16);
+        write_le16(h + 20, fmt.format == SampleFormat::Float32 ? 3 : 1);
+        write_le16(h + 22, (uint16_t)fmt.channels);
+        write_le32(h + 24, (uint32_t)fmt.sampleRate);
+        write_le32(h + 28, (uint32_t)fmt.sampleRate * fmt.channels * sampleBytes);
+        write_le16(h + 32, (uint16_t)(fmt.channels * sampleBytes));
+        write_le16(h + 34, (uint16_t)(sampleBytes * 8));
+        memcpy(h + 36, "data", 4);
+        write_le32(h + 40, dataSize);
+    }
+
+    FILE *file = nullptr;
+    StreamFormat fmt;
+    bool isRaw = false;
+    uint64_t dataBytes = 0;
+    std::vector<unsigned char> bytes;
+};
+
+// ---------------------------------------------------------------------------
+// Rendering
+
+struct FileResult
+{
+    bool ok = false;
+    double seconds = 0;     // rendered audio, including the tail
+    std::string error;
+};
+
+// One per worker thread: engine and chunk buffers are reused for every file
+class Renderer
+{
+public:
+    explicit Renderer(const Options& options)
+        : opt(options),
+          reverb(make_mk_freeverb(options.numCombs, options.features, 48000.0f, maxFileRate)),
+          interleaved(options.chunk * 2), inL(options.chunk), inR(options.chunk),
+          outL(options.chunk), outR(options.chunk)
+    {
+        if (opt.pipeline) pipeline.reset(new mk_freeverb_pipeline);
+
+        // Apply the preset queued by the constructor now, so it cannot
+        // override the one applied per file
+        reverb->process_block(nullptr, nullptr, nullptr, nullptr, 0);
+    }
+
+    FileResult render(const fs::path& input, const fs::path& output)
+    {
+#if MK_RENDER_HAVE_MMAP
+        if (opt.mmap && opt.rawChannels == 2 && AudioReader::is_raw(input))
+            return render_mapped(input, output);
+#endif
+
+        FileResult result;
+        AudioReader reader;
+        if (!reader.open(input, opt, result.error)) return result;
+
+        const StreamFormat in = reader.format();
+        if (in.channels < 1 || in.channels > 2) { result.error = "only mono and stereo are supported"; return result; }
+        if (in.sampleRate <= 0 || in.sampleRate > maxFileRate) { result.error = "unsupported sample rate"; return result; }
+
+        const bool raw = AudioReader::is_raw(input);
+        StreamFormat out = in;
+        out.channels = 2;
+        if (raw) out.format = SampleFormat::Float32;
+        else if (opt.format != SampleFormat::Same) out.format = opt.format;
+
+        AudioWriter writer;
+        if (!writer.open(output, out, raw)) { result.error = "cannot create " + output.string(); return result; }
+
+        start_file(in.sampleRate);
+
+        uint64_t frames = 0;
+        size_t n;
+        while ((n = reader.read(interleaved.data(), opt.chunk)) > 0)
+        {
+            for (size_t i = 0; i < n; i++)
+            {
+                inL[i] = interleaved[i * in.channels];
+                inR[i] = interleaved[i * in.channels + in.channels - 1];
+            }
+            if (!process(writer, n)) { result.error = "write failed"; return result; }
+            frames += n;
+        }
+
+        // Feed silence until the tail is inaudible
+        std::fill(inL.begin(), inL.end(), 0.0f);
+        std::fill(inR.begin(), inR.end(), 0.0f);
+        const float threshold = std::pow(10.0f, opt.tailThreshold / 20.0f);
+        const uint64_t maxTail = (uint64_t)(opt.maxTail * in.sampleRate);
+        for (uint64_t tail = 0; tail < maxTail; )
+        {
+            n = (size_t)std::min<uint64_t>(opt.chunk, maxTail - tail);
+            if (!process(writer, n)) { result.error = "write failed"; return result; }
+            tail += n;
+            frames += n;
+            if (peak(n) < threshold || reverb->is_sleeping()) break;
+        }
+
+        if (!writer.close()) { result.error = "write failed"; return result; }
+        result.ok = true;
+        result.seconds = frames / in.sampleRate;
+        return result;
+    }
+
+#if MK_RENDER_HAVE_MMAP
+    // Zero-copy path for interleaved stereo float32: input and output are
+    // mapped and processed in place with a stride of 2. The output is sized
+    // for the longest possible tail up front and truncated when done.
+    FileResult render_mapped(const fs::path& input, const fs::path& output)
+    {
+        FileResult result;
+        const size_t frameBytes = 2 * sizeof(float);
+
+        const int inFd = ::open(input.string().c_str(), O_RDONLY);
+        if (inFd < 0) { result.error = "cannot open"; return result; }
+        struct stat st;
+        if (fstat(inFd, &st) != 0) { ::close(inFd); result.error = "cannot stat"; return result; }
+        const size_t inFrames = (size_t)st.st_size / frameBytes;
+
+        float *in = nullptr;
+        if (inFrames > 0)
+        {
+            void *map = mmap(nullptr, inFrames * frameBytes, PROT_READ, MAP_PRIVATE, inFd, 0);
+            if (map == MAP_FAILED) { ::close(inFd); result.error = "cannot map input"; return result; }
+            in = static_cast<float *>(map);
+            madvise(map, inFrames * frameBytes, MADV_SEQUENTIAL);
+        }
+        ::close(inFd);
+
+        const size_t maxTail = (size_t)(opt.maxTail * opt.rawRate);
+        const size_t capacity = (inFrames + maxTail) * frameBytes;
+        const int outFd = ::open(output.string().c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        void *outMap = MAP_FAILED;
+        if (outFd >= 0 && capacity > 0 && ftruncate(outFd, (off_t)capacity) == 0)
+            outMap = mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, outFd, 0);
+        if (outMap == MAP_FAILED)
+        {
+            if (in) munmap(in, inFrames * frameBytes);
+            if (outFd >= 0) ::close(outFd);
+            result.error = "cannot map " + output.string();
+            return result;
+        }
+        madvise(outMap, capacity, MADV_SEQUENTIAL);
+#ifdef MADV_HUGEPAGE
+        if (opt.hugepages)
+        {
+            madvise(outMap, capacity, MADV_HUGEPAGE);
+            if (in) madvise(in, inFrames * frameBytes, MADV_HUGEPAGE);
+        }
+#endif
+        float *out = static_cast<float *>(outMap);
+
+        start_file(opt.rawRate);
+
+        // processreplace() only reads its inputs, the mapping is read-only
+        for (size_t pos = 0; pos < inFrames; pos += opt.chunk)
+        {
+            const size_t n = std::min<size_t>(opt.chunk, inFrames - pos);
+            float *src = in + 2 * pos;
+            float *dst = out + 2 * pos;
+            if (pipeline)
+                reverb->process_pipelined(*pipeline, src, src + 1, dst, dst + 1, (long)n, 2);
+            else
+                reverb->processreplace(src, src + 1, dst, dst + 1, (long)n, 2);
+        }
+
+        // Tail: interleaved zeros as input, same stride
+        std::vector<float> silence(2 * opt.chunk, 0.0f);
+        size_t frames = inFrames;
+        const float threshold = std::pow(10.0f, opt.tailThreshold / 20.0f);
+        for (size_t tail = 0; tail < maxTail; )
+        {
+            const size_t n = std::min<size_t>(opt.chunk, maxTail - tail);
+            float *dst = out + 2 * frames;
+            if (pipeline)
+                reverb->process_pipelined(*pipeline, silence.data(), silence.data() + 1, dst, dst + 1, (long)n, 2);
+            else
+                reverb->processreplace(silence.data(), silence.data() + 1, dst, dst + 1, (long)n, 2);
+            tail += n;
+            frames += n;
+
+            float p = 0.0f;
+            for (size_t i = 0; i < 2 * n; i++)
+                p = std::max(p, std::fabs(dst[i]));
+            if (p < threshold || reverb->is_sleeping()) break;
+        }
+
+        if (in) munmap(in, inFrames * frameBytes);
+        bool ok = munmap(outMap, capacity) == 0;
+        ok = ftruncate(outFd, (off_t)(frames * frameBytes)) == 0 && ok;
+        ok = ::close(outFd) == 0 && ok;
+        if (!ok) { result.error = "write failed"; return result; }
+
+        result.ok = true;
+        result.seconds = frames / opt.rawRate;
+        return result;
+    }
+#endif
+
+private:
+    // Puts the engine back into the state a new one would be in before the
+    // file's preset is applied. The input filter smooths each parameter
+    // change against the previous one, so going through the default preset
+    // first keeps the output independent of the files rendered before.
+    void start_file(float sampleRate)
+    {
+        reverb->apply_preset(ReverbPresets::DEFAULT_PRESET);
+        reverb->set_sample_rate(sampleRate);
+        reverb->apply_preset(*ReverbPresets::ALL_PRESETS[opt.preset]);
+    }
+
+    bool process(AudioWriter& writer, size_t n)
+    {
+        if (pipeline)
+            reverb->process_pipelined(*pipeline, inL.data(), inR.data(), outL.data(), outR.data(), (long)n, 1);
+        else
+            reverb->process_block(inL.data(), inR.data(), outL.data(), outR.data(), (int)n);
+        for (size_t i = 0; i < n; i++)
+        {
+            interleaved[2 * i] = outL[i];
+            interleaved[2 * i + 1] = outR[i];
+        }
+        return writer.write(interleaved.data(), n);
+    }
+
+    float peak(size_t n) const
+    {
+        float p = 0.0f;
+        for (size_t i = 0; i < n; i++)
+            p = std::max(p, std::max(std::fabs(outL[i]), std::fabs(outR[i])));
+        return p;
+    }
+
+    const Options& opt;
+    std::unique_ptr<mk_freeverb_processor> reverb;
+    std::unique_ptr<mk_freeverb_pipeline> pipeline;  // with --pipeline
+    std::vector<float> interleaved, inL, inR, outL, outR;
+};
+
+bool is_audio_file(const fs::path& path)
+{
+    std::string ext = path.extension().string();
+    std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+    return ext == ".wav" || ext == ".raw";
+}
+
+// ---------------------------------------------------------------------------
+// Command line
+
+bool option_value(const char *arg, const char *name, const char *shortName,
+                  int argc, char **argv, int& i, const char *&value)
+{
+    const size_t len = strlen(name);
+    if (!strncmp(arg, name, len) && arg[len] == '=') { value = arg + len + 1; return true; }
+    if ((!strcmp(arg, name) || (shortName && !strcmp(arg, shortName))) && i + 1 < argc)
+    {
+        value = argv[++i];
+        return true;
+    }
+    return false;
+}
+
+void usage(const char *argv0)
+{
+    fprintf(stderr,
+            "usage: %s [options] -o <output dir> <file or dir>...\n"
+            "  -o, --output=DIR        output directory\n"
+            "  -p, --preset=N          preset index (see --list-presets)\n"
+            "  -j, --jobs=N            worker threads\n"
+            "  --format=same|16|24|32f output sample format\n"
+            "  --tail-threshold=DB     end the tail below this peak level (default -90)\n"
+            "  --max-tail=SECONDS      tail length limit (default 30)\n"
+            "  --chunk=FRAMES          streaming chunk size (default 4096)\n"
+            "  --combs=1-8             comb count\n"
+            "  --features=MASK         1 predelay, 2 crossfade, 4 input filter\n"
+            "  --raw-rate=HZ           sample rate of .raw inputs\n"
+            "  --raw-channels=1|2      channels of .raw inputs\n"
+            "  --mmap                  map stereo .raw files, no copies\n"
+            "  --hugepages             with --mmap, request transparent hugepages\n"
+            "  --pipeline              render each file on 4 threads\n"
+            "  --list-presets          print preset indices\n"
+            "  -v, --verbose           report every file\n", argv0);
+}
+
+bool parse_args(int argc, char **argv, Options& opt)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        const char *a = argv[i];
+        const char *v = nullptr;
+        if (option_value(a, "--output", "-o", argc, argv, i, v)) opt.outputDir = v;
+        else if (option_value(a, "--preset", "-p", argc, argv, i, v)) opt.preset = atoi(v);
+        else if (option_value(a, "--jobs", "-j", argc, argv, i, v)) opt.jobs = atoi(v);
+        else if (option_value(a, "--tail-threshold", nullptr, argc, argv, i, v)) opt.tailThreshold = (float)atof(v);
+        else if (option_value(a, "--max-tail", nullptr, argc, argv, i, v)) opt.maxTail = (float)atof(v);
+        else if (option_value(a, "--chunk", nullptr, argc, argv, i, v)) opt.chunk = atoi(v);
+        else if (option_value(a, "--combs", nullptr, argc, argv, i, v)) opt.numCombs = atoi(v);
+        else if (option_value(a, "--features", nullptr, argc, argv, i, v)) opt.features = (unsigned)strtoul(v, nullptr, 0);
+        else if (option_value(a, "--raw-rate", nullptr, argc, argv, i, v)) opt.rawRate = (float)atof(v);
+        else if (option_value(a, "--raw-channels", nullptr, argc, argv, i, v)) opt.rawChannels = atoi(v);
+        else if (option_value(a, "--format", nullptr, argc, argv, i, v))
+        {
+            if (!strcmp(v, "same")) opt.format = SampleFormat::Same;
+            else if (!strcmp(v, "16")) opt.format = SampleFormat::Int16;
+            else if (!strcmp(v, "24")) opt.format = SampleFormat::Int24;
+            else if (!strcmp(v, "32f")) opt.format = SampleFormat::Float32;
+            else { fprintf(stderr, "unknown format %s\n", v); return false; }
+        }
+        else if (!strcmp(a, "--list-presets"))
+        {
+            for (int p = 0; p < ReverbPresets::NUM_PRESETS; p++)
+                printf("%d  %s\n", p, ReverbPresets::PRESET_NAMES[p]);
+            exit(0);
+        }
+        else if (!strcmp(a, "-v") || !strcmp(a, "--verbose")) opt.verbose = true;
+        else if (!strcmp(a, "--mmap")) opt.mmap = true;
+        else if (!strcmp(a, "--hugepages")) opt.hugepages = true;
+        else if (!strcmp(a, "--pipeline")) opt.pipeline = true;
+        else if (a[0] == '-' && a[1]) { fprintf(stderr, "unknown option %s\n", a); return false; }
+        else opt.inputs.push_back(a);
+    }
+
+    if (opt.outputDir.empty() || opt.inputs.empty()) return false;
+    if (opt.preset < 0 || opt.preset >= ReverbPresets::NUM_PRESETS) { fprintf(stderr, "preset out of range\n"); return false; }
+    if (opt.numCombs < 1 || opt.numCombs > numcombs) { fprintf(stderr, "combs must be 1-8\n"); return false; }
+    if (opt.chunk < 1 || opt.rawChannels < 1 || opt.rawChannels > 2 || opt.rawRate <= 0) return false;
+    if (opt.jobs <= 0)
+    {
+        // A pipelined worker keeps 4 threads busy
+        opt.jobs = (int)std::max(1u, std::thread::hardware_concurrency() / (opt.pipeline ? 4 : 1));
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    Options opt;
+    if (!parse_args(argc, argv, opt))
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    std::vector<fs::path> files;
+    for (const std::string& input : opt.inputs)
+    {
+        std::error_code ec;
+        if (fs::is_directory(input, ec))
+        {
+            for (const auto& entry : fs::directory_iterator(input, ec))
+                if (entry.is_regular_file() && is_audio_file(entry.path()))
+                    files.push_back(entry.path());
+        }
+        else
+        {
+            files.push_back(input);
+        }
+    }
+    std::sort(files.begin(), files.end());
+
+    std::error_code ec;
+    fs::create_directories(opt.outputDir, ec);
+    const fs::path outDir = fs::absolute(opt.outputDir, ec);
+
+    std::atomic<size_t> next{0};
+    std::atomic<int> failed{0};
+    std::mutex logMutex;
+    double audioSeconds = 0;
+
+    auto worker = [&]() {
+        Renderer renderer(opt);
+        double seconds = 0;
+        for (size_t i; (i = next++) < files.size(); )
+        {
+            const fs::path& input = files[i];
+            const fs::path output = outDir / input.filename();
+            std::error_code sameFile;
+            if (fs::equivalent(input, output, sameFile))
+            {
+                std::lock_guard<std::mutex> lock(logMutex);
+                fprintf(stderr, "%s: refusing to overwrite the input\n", input.string().c_str());
+                failed++;
+                continue;
+            }
+
+            FileResult r = renderer.render(input, output);
+            seconds += r.seconds;
+            if (!r.ok) failed++;
+            if (!r.ok || opt.verbose)
+            {
+                std::lock_guard<std::mutex> lock(logMutex);
+                if (r.ok) fprintf(stderr, "%s: %.2f s\n", input.string().c_str(), r.seconds);
+                else fprintf(stderr, "%s: %s\n", input.string().c_str(), r.error.c_str());
+            }
+        }
+        std::lock_guard<std::mutex> lock(logMutex);
+        audioSeconds += seconds;
+    };
+
+    const auto start = std::chrono::steady_clock::now();
+    const int jobs = (int)std::min<size_t>(opt.jobs, std::max<size_t>(files.size(), 1));
+    std::vector<std::thread> pool;
+    for (int j = 1; j < jobs; j++)
+        pool.emplace_back(worker);
+    worker();
+    for (std::thread& t : pool)
+        t.join();
+    const double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    const size_t rendered = files.size() - failed;
+    fprintf(stderr, "%zu files (%d failed) in %.2f s: %.1f files/s, %.2f s of audio, %.1fx realtime, %d threads\n",
+            rendered, failed.load(), wall, rendered / wall, audioSeconds, audioSeconds / wall, jobs);
+    return failed ? 1 : 0;
+}
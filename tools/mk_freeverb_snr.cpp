@@ -0,0 +1,248 @@
+// Fixed-point accuracy check: measures mk_freeverb_fixed against the float
+// reverb as a signal-to-noise ratio, the float output being the signal and
+// the difference the noise.
+//
+// Usage: mk_freeverb_snr [--seconds=S] [--min-q15=DB] [--min-q31=DB]
+//
+// Every preset is rendered through basic_mk_freeverb<combs, None> and
+// mk_freeverb_fixed<int16_t/int32_t, combs> with 4 and 8 combs, and again
+// with the input filter (ReverbFeatures::InputFilter against
+// mk_freeverb_fixed<..., true>), so the filter has to reach each preset's
+// cutoff the way the float one does. The input biquad is also checked on
+// its own for a few cutoff/resonance pairs: FixedFilter retargeted from
+// another cutoff and left to converge, against a float biquad designed
+// for the target directly. The test signal holds noise bursts, a sine sweep
+// and silence, all exactly representable in Q15, so both formats see the
+// same input as the float path. Exits with 1 if any case falls below the
+// minimum for its format (defaults 25 dB for Q15, 100 dB for Q31).
+
+#include "mk_freeverb.hpp"
+#include "mk_freeverb_fixed.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+namespace {
+
+struct Signal
+{
+    std::vector<float> left, right;
+};
+
+Signal test_signal(float sampleRate, float seconds)
+{
+    const long frames = static_cast<long>(sampleRate * seconds);
+    Signal s;
+    s.left.resize(frames);
+    s.right.resize(frames);
+
+    unsigned seed = 12345;
+    double phase = 0;
+    for (long i = 0; i < frames; i++)
+    {
+        // 0.5 s noise burst, 1 s sweep, 0.5 s silence, repeated
+        const long period = static_cast<long>(2 * sampleRate);
+        const long t = i % period;
+        seed = seed * 1664525u + 1013904223u;
+        const float noise = ((seed >> 8) / 16777216.0f) * 2.0f - 1.0f;
+        phase += 2 * M_PI * (50.0 + 15000.0 * t / period) / sampleRate;
+
+        float l = 0, r = 0;
+        if (t < period / 4)
+        {
+            l = 0.5f * noise;
+            r = -0.3f * noise;
+        }
+        else if (t < period * 3 / 4)
+        {
+            l = 0.4f * static_cast<float>(std::sin(phase));
+            r = 0.4f * static_cast<float>(std::cos(phase));
+        }
+
+        // Round to Q15 so every format gets the same input
+        s.left[i] = fixed_to_float(fixed_sample<int16_t>(l));
+        s.right[i] = fixed_to_float(fixed_sample<int16_t>(r));
+    }
+    return s;
+}
+
+double snr_db(const std::vector<float>& reference, const std::vector<float>& test)
+{
+    double signal = 0, noise = 0;
+    for (size_t i = 0; i < reference.size(); i++)
+    {
+        const double d = static_cast<double>(test[i]) - reference[i];
+        signal += static_cast<double>(reference[i]) * reference[i];
+        noise += d * d;
+    }
+    if (signal == 0) return NAN;
+    if (noise == 0) return INFINITY;
+    return 10 * std::log10(signal / noise);
+}
+
+template <int combs, unsigned features>
+Signal render_float(const Signal& in, const ReverbPreset& preset, float sampleRate)
+{
+    std::unique_ptr<basic_mk_freeverb<combs, features>> reverb(new basic_mk_freeverb<combs, features>(sampleRate, sampleRate));
+    reverb->process_block(nullptr, nullptr, nullptr, nullptr, 0);
+    reverb->apply_preset(preset);
+
+    Signal out;
+    out.left.resize(in.left.size());
+    out.right.resize(in.right.size());
+    reverb->process_block(in.left.data(), in.right.data(), out.left.data(), out.right.data(), static_cast<int>(in.left.size()));
+    return out;
+}
+
+template <typename sample_t, int combs, bool inputFilter>
+Signal render_fixed(const Signal& in, const ReverbPreset& preset, float sampleRate)
+{
+    const size_t frames = in.left.size();
+    std::vector<sample_t> inL(frames), inR(frames), outL(frames), outR(frames);
+    for (size_t i = 0; i < frames; i++)
+    {
+        inL[i] = fixed_sample<sample_t>(in.left[i]);
+        inR[i] = fixed_sample<sample_t>(in.right[i]);
+    }
+
+    std::unique_ptr<mk_freeverb_fixed<sample_t, combs, inputFilter>> reverb(new mk_freeverb_fixed<sample_t, combs, inputFilter>(sampleRate));
+    reverb->apply_preset(preset);
+    reverb->processreplace(inL.data(), inR.data(), outL.data(), outR.data(), static_cast<long>(frames), 1);
+
+    Signal out;
+    out.left.resize(frames);
+    out.right.resize(frames);
+    for (size_t i = 0; i < frames; i++)
+    {
+        out.left[i] = fixed_to_float(outL[i]);
+        out.right[i] = fixed_to_float(outR[i]);
+    }
+    return out;
+}
+
+double stereo_snr(const Signal& reference, const Signal& test)
+{
+    std::vector<float> ref(reference.left), out(test.left);
+    ref.insert(ref.end(), reference.right.begin(), reference.right.end());
+    out.insert(out.end(), test.right.begin(), test.right.end());
+    return snr_db(ref, out);
+}
+
+// Lowpass designed for cutoff/resonance directly, direct form I. The
+// state is double: near its poles a float32 recursion is itself only
+// about 100 dB clean, too close to Q31
+std::vector<float> converged_biquad(const std::vector<float>& in, float sampleRate, float cutoff, float resonance)
+{
+    float b0, b1, b2, a1, a2;
+    Filter::design(Filter::Lowpass, Filter::prewarp(cutoff, sampleRate), Filter::fast_db_to_factor(resonance), b0, b1, b2, a1, a2);
+
+    std::vector<float> out(in.size());
+    double x1 = 0, x2 = 0, y1 = 0, y2 = 0;
+    for (size_t i = 0; i < in.size(); i++)
+    {
+        const double y = b0 * in[i] + b1 * x1 + b2 * x2 - a1 * y1 - a2 * y2;
+        x2 = x1;
+        x1 = in[i];
+        y2 = y1;
+        y1 = y;
+        out[i] = static_cast<float>(y);
+    }
+    return out;
+}
+
+template <typename sample_t>
+double filter_snr(const std::vector<float>& in, float sampleRate, float cutoff, float resonance)
+{
+    // Designed for 1 kHz first, then retargeted: a second of silence gives
+    // the smoothing time to arrive and leaves the delay line at zero
+    FixedFilter<sample_t> fixed(Filter::Lowpass, sampleRate);
+    fixed.setCutoff(1000.0f);
+    fixed.process(0);
+    fixed.setCutoff(cutoff);
+    fixed.setResonance(resonance);
+    for (int i = 0; i < static_cast<int>(sampleRate); i++)
+        fixed.process(0);
+
+    std::vector<float> out(in.size());
+    for (size_t i = 0; i < in.size(); i++)
+        out[i] = fixed_to_float(fixed.process(fixed_sample<sample_t>(in[i])));
+    return snr_db(converged_biquad(in, sampleRate, cutoff, resonance), out);
+}
+
+struct Limits
+{
+    double q15 = 25, q31 = 100;
+    int failures = 0;
+};
+
+void report(const char *name, const char *format, double snr, double minimum, Limits& limits)
+{
+    if (std::isnan(snr))
+    {
+        printf("%-32s %-4s   silent\n", name, format);
+        return;
+    }
+    const bool ok = snr >= minimum;
+    printf("%-32s %-4s %7.1f dB%s\n", name, format, snr, ok ? "" : "  FAIL");
+    if (!ok) limits.failures++;
+}
+
+template <int combs, bool inputFilter>
+void check_reverb(const Signal& in, float sampleRate, Limits& limits)
+{
+    const unsigned features = inputFilter ? ReverbFeatures::InputFilter : ReverbFeatures::None;
+    for (int p = 0; p < ReverbPresets::NUM_PRESETS; p++)
+    {
+        const ReverbPreset& preset = *ReverbPresets::ALL_PRESETS[p];
+        const Signal reference = render_float<combs, features>(in, preset, sampleRate);
+
+        char name[64];
+        snprintf(name, sizeof(name), "%d combs, %s%s", combs, ReverbPresets::PRESET_NAMES[p], inputFilter ? ", filter" : "");
+        report(name, "Q15", stereo_snr(reference, render_fixed<int16_t, combs, inputFilter>(in, preset, sampleRate)), limits.q15, limits);
+        report(name, "Q31", stereo_snr(reference, render_fixed<int32_t, combs, inputFilter>(in, preset, sampleRate)), limits.q31, limits);
+    }
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    float seconds = 6;
+    Limits limits;
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strncmp(argv[i], "--seconds=", 10)) seconds = static_cast<float>(atof(argv[i] + 10));
+        else if (!strncmp(argv[i], "--min-q15=", 10)) limits.q15 = atof(argv[i] + 10);
+        else if (!strncmp(argv[i], "--min-q31=", 10)) limits.q31 = atof(argv[i] + 10);
+        else
+        {
+            fprintf(stderr, "usage: %s [--seconds=S] [--min-q15=DB] [--min-q31=DB]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    const float sampleRate = 48000.0f;
+    const Signal in = test_signal(sampleRate, seconds);
+
+    check_reverb<4, false>(in, sampleRate, limits);
+    check_reverb<8, false>(in, sampleRate, limits);
+    check_reverb<4, true>(in, sampleRate, limits);
+    check_reverb<8, true>(in, sampleRate, limits);
+
+    const float filters[][2] = { { 200.0f, 0.0f }, { 2000.0f, 0.0f }, { 8000.0f, 0.5f }, { 8000.0f, 6.0f } };
+    for (const auto& f : filters)
+    {
+        char name[64];
+        snprintf(name, sizeof(name), "biquad %.0f Hz, %.1f dB", f[0], f[1]);
+        report(name, "Q15", filter_snr<int16_t>(in.left, sampleRate, f[0], f[1]), limits.q15, limits);
+        report(name, "Q31", filter_snr<int32_t>(in.left, sampleRate, f[0], f[1]), limits.q31, limits);
+    }
+
+    if (limits.failures)
+        printf("%d case(s) below the minimum SNR\n", limits.failures);
+    return limits.failures ? 1 : 0;
+}
@@ -0,0 +1,69 @@
+#!/bin/sh
+# Golden-output regression over build configurations
+#
+# Builds mk_freeverb_golden with the default macros and checks it, including
+# its throughput, against the committed tools/mk_freeverb_golden.ref; a
+# missing reference file or case fails the run. The default build then
+# dumps its renders, and each macro set below is rebuilt and checked
+# without the throughput check: builds that keep the arithmetic against the
+# references, the others against the renders with the tolerance
+# mk_freeverb_golden derives from their delay storage, denormal mode and
+# block size.
+#
+# Usage: tools/run_golden.sh [mk_freeverb_golden options...]
+#        tools/run_golden.sh --write   rewrite the references from this build
+# Environment: CXX (default c++), CXXFLAGS (default -O2)
+#
+# Exits non-zero if any build fails its check.
+
+set -e
+
+root=$(cd "$(dirname "$0")/.." && pwd)
+ref="$root/tools/mk_freeverb_golden.ref"
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT
+cxx=${CXX:-c++}
+flags=${CXXFLAGS:--O2}
+
+build() {
+  $cxx -std=c++17 -DNDEBUG $flags "$@" -I"$root" \
+    "$root/tools/mk_freeverb_golden.cpp" "$root"/*.cpp -o "$work/mk_freeverb_golden" -lpthread
+}
+
+build
+if [ "$1" = "--write" ]; then
+  shift
+  echo "== writing references to $ref" >&2
+  exec "$work/mk_freeverb_golden" --write="$ref" "$@"
+fi
+if [ ! -f "$ref" ]; then
+  echo "no references at $ref, write them with tools/run_golden.sh --write" >&2
+  exit 2
+fi
+
+failed=""
+echo "== default build" >&2
+"$work/mk_freeverb_golden" --check="$ref" "$@" || failed="$failed default"
+mkdir "$work/renders"
+"$work/mk_freeverb_golden" --dump="$work/renders"
+
+for macros in \
+  "-DMK_FREEVERB_ENABLE_SIMD=0" \
+  "-DMK_FREEVERB_ENABLE_COMB_BANK=0" \
+  "-DMK_FREEVERB_BLOCK_SIZE=64" \
+  "-DMK_FREEVERB_ENABLE_STATS=1" \
+  "-DMK_FREEVERB_DENORMAL_MODE=0" \
+  "-DMK_FREEVERB_DENORMAL_MODE=2" \
+  "-DMK_FREEVERB_DELAY_STORAGE=1" \
+  "-DMK_FREEVERB_DELAY_STORAGE=2"
+do
+  echo "== $macros" >&2
+  build $macros
+  "$work/mk_freeverb_golden" --check="$ref" --renders="$work/renders" --no-perf "$@" || failed="$failed [$macros]"
+done
+
+if [ -n "$failed" ]; then
+  echo "failed:$failed" >&2
+  exit 1
+fi
+echo "all builds passed" >&2
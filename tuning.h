@@ -29,6 +29,7 @@ const int	stereospread	= 23;
 // they will probably be OK for 48KHz sample rate
 // but would need scaling for 96KHz (or other) sample rates.
 // The values were obtained by listening tests.
+// Use scaledtuning() to convert them to the running sample rate.
 const int combtuningL1		= 1116;
 const int combtuningR1		= 1116+stereospread;
 const int combtuningL2		= 1188;
@@ -54,6 +55,20 @@ const int allpasstuningR3	= 341+stereospread;
 const int allpasstuningL4	= 225;
 const int allpasstuningR4	= 225+stereospread;
 
+// The same values indexed by filter number
+constexpr int combtuningsL[numcombs]	= { combtuningL1, combtuningL2, combtuningL3, combtuningL4,
+									combtuningL5, combtuningL6, combtuningL7, combtuningL8 };
+constexpr int combtuningsR[numcombs]	= { combtuningR1, combtuningR2, combtuningR3, combtuningR4,
+									combtuningR5, combtuningR6, combtuningR7, combtuningR8 };
+constexpr int allpasstuningsL[numallpasses]	= { allpasstuningL1, allpasstuningL2, allpasstuningL3, allpasstuningL4 };
+constexpr int allpasstuningsR[numallpasses]	= { allpasstuningR1, allpasstuningR2, allpasstuningR3, allpasstuningR4 };
+
+// Scale a 44.1KHz delay length to another sample rate
+constexpr int scaledtuning(int tuning, double samplerate)
+{
+	return tuning*samplerate/44100.0 + 0.5 < 1 ? 1 : (int)(tuning*samplerate/44100.0 + 0.5);
+}
+
 #endif//_tuning_
 
 //ends